@@ -0,0 +1,207 @@
+#define VMA_IMPLEMENTATION
+#include "vk_allocator.hpp"
+
+namespace V {
+  
+  void* VulkanAllocation::map() {
+    if(m_mapped) return m_mapped;
+    if(vmaMapMemory(m_allocator, m_alloc, &m_mapped) != VK_SUCCESS) {
+      Logger::error("Failed to map allocation");
+      m_mapped = nullptr;
+    }
+    return m_mapped;
+  }
+  
+  void VulkanAllocation::unmap() {
+    if(!m_mapped || m_persistent) return;
+    vmaUnmapMemory(m_allocator, m_alloc);
+    m_mapped = nullptr;
+  }
+  
+  vk::DeviceSize VulkanAllocation::getSize() const {
+    if(!m_alloc) return 0;
+    VmaAllocationInfo info{};
+    vmaGetAllocationInfo(m_allocator, m_alloc, &info);
+    return info.size;
+  }
+  
+  void VulkanAllocation::release() {
+    if(!m_alloc) return;
+    if(m_mapped && !m_persistent) {
+      vmaUnmapMemory(m_allocator, m_alloc);
+    }
+    vmaFreeMemory(m_allocator, m_alloc);
+    m_alloc = nullptr;
+    m_mapped = nullptr;
+    m_persistent = false;
+  }
+  
+  //====================================================================================================
+  
+  VulkanAllocator::VulkanAllocator() {
+    
+  }
+  
+  VulkanAllocator::~VulkanAllocator() {
+    if(m_allocator) {
+      vmaDestroyAllocator(m_allocator);
+    }
+  }
+  
+  bool VulkanAllocator::init(
+    vk::raii::Instance& inst,
+    vk::raii::PhysicalDevice& pDev,
+    vk::raii::Device& lDev,
+    bool memoryBudget
+  ) {
+    
+    VmaVulkanFunctions funcs{};
+    funcs.vkGetInstanceProcAddr = inst.getDispatcher()->vkGetInstanceProcAddr;
+    funcs.vkGetDeviceProcAddr = lDev.getDispatcher()->vkGetDeviceProcAddr;
+    
+    VmaAllocatorCreateInfo info{};
+    info.physicalDevice = *pDev;
+    info.device = *lDev;
+    info.instance = *inst;
+    info.pVulkanFunctions = &funcs;
+    info.vulkanApiVersion = VK_API_VERSION_1_3;
+    if(memoryBudget) {
+      info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
+    
+    if(vmaCreateAllocator(&info, &m_allocator) != VK_SUCCESS) {
+      Logger::error("Failed to create memory allocator");
+      return false;
+    }
+    m_memoryBudget = memoryBudget;
+    
+    Logger::info("GPU memory budget: {}", memoryBudget ? "VK_EXT_memory_budget" : "estimated from own allocations");
+    return true;
+  }
+  
+  bool VulkanAllocator::allocBuf(
+    const vk::raii::Buffer& buf,
+    vk::MemoryPropertyFlags memProps,
+    VmaAllocationCreateFlags flags,
+    VulkanAllocation& alloc
+  ) {
+    
+    VmaAllocationCreateInfo createInfo{};
+    createInfo.flags = flags;
+    createInfo.usage = VMA_MEMORY_USAGE_UNKNOWN;
+    createInfo.requiredFlags = static_cast<VkMemoryPropertyFlags>(memProps);
+    
+    VulkanAllocation res;
+    VmaAllocationInfo allocInfo{};
+    if(vmaAllocateMemoryForBuffer(m_allocator, *buf, &createInfo, &res.m_alloc, &allocInfo) != VK_SUCCESS) {
+      Logger::error("Failed to allocate buffer memory");
+      return false;
+    }
+    res.m_allocator = m_allocator;
+    
+    if(vmaBindBufferMemory(m_allocator, res.m_alloc, *buf) != VK_SUCCESS) {
+      Logger::error("Failed to bind buffer memory");
+      return false;
+    }
+    
+    if(flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) {
+      res.m_mapped = allocInfo.pMappedData;
+      res.m_persistent = true;
+    }
+    
+    alloc = std::move(res);
+    return true;
+  }
+  
+  bool VulkanAllocator::allocImg(
+    const vk::raii::Image& img,
+    vk::MemoryPropertyFlags memProps,
+    VmaAllocationCreateFlags flags,
+    VulkanAllocation& alloc
+  ) {
+    
+    VmaAllocationCreateInfo createInfo{};
+    createInfo.flags = flags;
+    createInfo.usage = VMA_MEMORY_USAGE_UNKNOWN;
+    createInfo.requiredFlags = static_cast<VkMemoryPropertyFlags>(memProps);
+    
+    VulkanAllocation res;
+    if(vmaAllocateMemoryForImage(m_allocator, *img, &createInfo, &res.m_alloc, nullptr) != VK_SUCCESS) {
+      Logger::error("Failed to allocate image memory");
+      return false;
+    }
+    res.m_allocator = m_allocator;
+    
+    if(vmaBindImageMemory(m_allocator, res.m_alloc, *img) != VK_SUCCESS) {
+      Logger::error("Failed to bind image memory");
+      return false;
+    }
+    
+    alloc = std::move(res);
+    return true;
+  }
+  
+  VulkanAllocStats VulkanAllocator::getStats() const {
+    VmaTotalStatistics total{};
+    vmaCalculateStatistics(m_allocator, &total);
+    
+    return {
+      .blockCount = total.total.statistics.blockCount,
+      .allocationCount = total.total.statistics.allocationCount,
+      .blockBytes = total.total.statistics.blockBytes,
+      .allocationBytes = total.total.statistics.allocationBytes
+    };
+  }
+  
+  std::vector<VulkanHeapBudget> VulkanAllocator::getHeapBudgets() const {
+    const VkPhysicalDeviceMemoryProperties* props = nullptr;
+    vmaGetMemoryProperties(m_allocator, &props);
+    
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetHeapBudgets(m_allocator, budgets.data());
+    
+    std::vector<VulkanHeapBudget> res;
+    res.reserve(props->memoryHeapCount);
+    for(uint32_t i = 0; i < props->memoryHeapCount; ++i) {
+      res.push_back({
+        .heap = i,
+        .deviceLocal = (props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+        .usage = budgets[i].usage,
+        .budget = budgets[i].budget,
+        .allocationBytes = budgets[i].statistics.allocationBytes
+      });
+    }
+    
+    return res;
+  }
+  
+  void VulkanAllocator::setFrameIndex(uint32_t frame) {
+    // lets VMA refresh the driver budget once per frame instead of on every query
+    vmaSetCurrentFrameIndex(m_allocator, frame);
+  }
+  
+  void VulkanAllocator::logStats() const {
+    VmaTotalStatistics total{};
+    vmaCalculateStatistics(m_allocator, &total);
+    
+    const auto& s = total.total.statistics;
+    Logger::info("GPU memory: {} allocations in {} blocks, {:.2f} / {:.2f} MB used",
+      s.allocationCount,
+      s.blockCount,
+      static_cast<float>(s.allocationBytes) / (1024.f * 1024.f),
+      static_cast<float>(s.blockBytes) / (1024.f * 1024.f)
+    );
+    
+    const VmaDetailedStatistics* heaps = total.memoryHeap;
+    for(uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; ++i) {
+      if(heaps[i].statistics.blockCount == 0) continue;
+      Logger::info("  - Heap {}: {} allocations, {:.2f} MB in {} blocks",
+        i,
+        heaps[i].statistics.allocationCount,
+        static_cast<float>(heaps[i].statistics.blockBytes) / (1024.f * 1024.f),
+        heaps[i].statistics.blockCount
+      );
+    }
+  }
+  
+}; //V
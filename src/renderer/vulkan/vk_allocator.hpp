@@ -0,0 +1,117 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+namespace V {
+  
+  // owns one VMA sub-allocation, freed on destruction like the raii handles
+  class VulkanAllocation {
+  public:
+    
+    VulkanAllocation() {}
+    VulkanAllocation(std::nullptr_t) {}
+    ~VulkanAllocation() { release(); }
+    
+    VulkanAllocation(const VulkanAllocation&) = delete;
+    VulkanAllocation& operator=(const VulkanAllocation&) = delete;
+    
+    VulkanAllocation(VulkanAllocation&& other) noexcept
+      : m_allocator(std::exchange(other.m_allocator, nullptr))
+      , m_alloc(std::exchange(other.m_alloc, nullptr))
+      , m_mapped(std::exchange(other.m_mapped, nullptr))
+      , m_persistent(std::exchange(other.m_persistent, false)) {}
+    
+    VulkanAllocation& operator=(VulkanAllocation&& other) noexcept {
+      if(this != &other) {
+        release();
+        m_allocator = std::exchange(other.m_allocator, nullptr);
+        m_alloc = std::exchange(other.m_alloc, nullptr);
+        m_mapped = std::exchange(other.m_mapped, nullptr);
+        m_persistent = std::exchange(other.m_persistent, false);
+      }
+      return *this;
+    }
+    
+    void* map();
+    void unmap();
+    void* getMapped() const { return m_mapped; }
+    vk::DeviceSize getSize() const;
+    
+    explicit operator bool() const { return m_alloc != nullptr; }
+  
+  private:
+    
+    friend class VulkanAllocator;
+    
+    void release();
+    
+    VmaAllocator m_allocator{nullptr};
+    VmaAllocation m_alloc{nullptr};
+    void* m_mapped{nullptr};
+    bool m_persistent{false};
+    
+  };
+  
+  struct VulkanAllocStats {
+    uint32_t blockCount{0};
+    uint32_t allocationCount{0};
+    vk::DeviceSize blockBytes{0};
+    vk::DeviceSize allocationBytes{0};
+  };
+  
+  struct VulkanHeapBudget {
+    uint32_t heap{0};
+    bool deviceLocal{false};
+    vk::DeviceSize usage{0};   // whole process, including memory VMA does not own
+    vk::DeviceSize budget{0};  // how much the process may use before the driver starts paging
+    vk::DeviceSize allocationBytes{0};
+  };
+  
+  // device-wide allocator: resources sub-allocate from large blocks per memory type
+  class VulkanAllocator {
+  public:
+    
+    VulkanAllocator();
+    ~VulkanAllocator();
+    
+    VulkanAllocator(const VulkanAllocator&) = delete;
+    VulkanAllocator& operator=(const VulkanAllocator&) = delete;
+    
+    bool init(
+      vk::raii::Instance& inst,
+      vk::raii::PhysicalDevice& pDev,
+      vk::raii::Device& lDev,
+      bool memoryBudget
+    );
+    
+    bool allocBuf(
+      const vk::raii::Buffer& buf,
+      vk::MemoryPropertyFlags memProps,
+      VmaAllocationCreateFlags flags,
+      VulkanAllocation& alloc
+    );
+    
+    bool allocImg(
+      const vk::raii::Image& img,
+      vk::MemoryPropertyFlags memProps,
+      VmaAllocationCreateFlags flags,
+      VulkanAllocation& alloc
+    );
+    
+    VulkanAllocStats getStats() const;
+    void logStats() const;
+    
+    // with VK_EXT_memory_budget the numbers come from the driver,
+    // otherwise VMA estimates them from its own allocations and the heap sizes
+    std::vector<VulkanHeapBudget> getHeapBudgets() const;
+    bool hasMemoryBudget() const { return m_memoryBudget; }
+    void setFrameIndex(uint32_t frame);
+  
+  private:
+    
+    VmaAllocator m_allocator{nullptr};
+    bool m_memoryBudget{false};
+    
+  };
+  
+}; //V
@@ -0,0 +1,116 @@
+#include "vk_budget.hpp"
+
+namespace V {
+  
+  VulkanMemoryBudget::VulkanMemoryBudget() {
+    
+  }
+  
+  VulkanMemoryBudget::~VulkanMemoryBudget() {
+    
+  }
+  
+  bool VulkanMemoryBudget::init(VulkanAllocator& allocator, VulkanUploader& uploader, VulkanDeletionQueue& deletion, vk::raii::Device& lDev) {
+    
+    m_allocator = &allocator;
+    m_uploader = &uploader;
+    m_deletion = &deletion;
+    m_lDev = &lDev;
+    
+    m_heaps = m_allocator->getHeapBudgets();
+    logHeaps();
+    
+    return true;
+  }
+  
+  void VulkanMemoryBudget::track(const std::shared_ptr<VulkanTexture>& texture) {
+    if(texture) m_textures.emplace_back(texture);
+  }
+  
+  void VulkanMemoryBudget::update(uint64_t frameNumber) {
+    
+    m_allocator->setFrameIndex(static_cast<uint32_t>(frameNumber));
+    m_heaps = m_allocator->getHeapBudgets();
+    
+    std::erase_if(m_textures, [](const auto& tex) { return tex.expired(); });
+    
+    // the numbers are refreshed every frame, the log only keeps up once a second
+    auto now = std::chrono::steady_clock::now();
+    if(now - m_lastLog >= std::chrono::seconds(1)) {
+      logHeaps();
+      m_lastLog = now;
+    }
+    
+    // usage only drops once the deletion queue has released the images of the previous evictions
+    if(frameNumber < m_evictFrame + MAX_FRAMES_IN_FLIGHT || !m_uploader->isDone(m_evictTicket)) return;
+    
+    vk::DeviceSize over = 0;
+    for(const auto& heap : m_heaps) {
+      if(!heap.deviceLocal || heap.budget == 0) continue;
+      
+      auto limit = static_cast<vk::DeviceSize>(static_cast<double>(heap.budget) * MEMORY_BUDGET_PRESSURE);
+      if(heap.usage > limit) over = std::max(over, heap.usage - limit);
+    }
+    
+    if(over > 0) {
+      m_evictFrame = frameNumber;
+      evict(over);
+    } else {
+      m_exhausted = false;
+    }
+  }
+  
+  void VulkanMemoryBudget::evict(vk::DeviceSize bytes) {
+    
+    std::vector<std::shared_ptr<VulkanTexture>> candidates;
+    for(const auto& weak : m_textures) {
+      auto tex = weak.lock();
+      if(tex && tex->getPriority() != TexturePriority::eResident) candidates.push_back(std::move(tex));
+    }
+    
+    std::ranges::sort(candidates, [](const auto& a, const auto& b) {
+      if(a->getPriority() != b->getPriority()) return a->getPriority() < b->getPriority();
+      return a->getByteSize() > b->getByteSize();
+    });
+    
+    vk::DeviceSize freed = 0;
+    uint32_t count = 0;
+    for(const auto& tex : candidates) {
+      if(freed >= bytes) break;
+      
+      vk::DeviceSize before = tex->getByteSize();
+      if(tex->downscale(*m_lDev, *m_allocator, *m_uploader, *m_deletion)) {
+        freed += before - tex->getByteSize();
+        ++count;
+      }
+    }
+    
+    if(count == 0) {
+      if(m_exhausted) return;
+      m_exhausted = true;
+      Logger::warn("GPU memory over budget by {:.2f} MB, nothing left to evict", static_cast<float>(bytes) / (1024.f * 1024.f));
+      return;
+    }
+    
+    m_evictTicket = m_uploader->flush();
+    Logger::info("GPU memory over budget by {:.2f} MB: {} textures dropped, {:.2f} MB released",
+      static_cast<float>(bytes) / (1024.f * 1024.f),
+      count,
+      static_cast<float>(freed) / (1024.f * 1024.f)
+    );
+  }
+  
+  void VulkanMemoryBudget::logHeaps() const {
+    Logger::debug("GPU memory budget ({}):", m_allocator->hasMemoryBudget() ? "driver" : "estimated");
+    for(const auto& heap : m_heaps) {
+      Logger::debug("  - Heap {}{}: {:.2f} / {:.2f} MB ({:.2f} MB ours)",
+        heap.heap,
+        heap.deviceLocal ? " (device local)" : "",
+        static_cast<float>(heap.usage) / (1024.f * 1024.f),
+        static_cast<float>(heap.budget) / (1024.f * 1024.f),
+        static_cast<float>(heap.allocationBytes) / (1024.f * 1024.f)
+      );
+    }
+  }
+  
+}; //V
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "vk_texture.hpp"
+
+namespace V {
+  
+  // watches the per-heap budget every frame and drops textures to lower resolutions,
+  // lowest priority and largest first, while a device-local heap is over MEMORY_BUDGET_PRESSURE
+  class VulkanMemoryBudget {
+  public:
+    
+    VulkanMemoryBudget();
+    ~VulkanMemoryBudget();
+    
+    VulkanMemoryBudget(const VulkanMemoryBudget&) = delete;
+    VulkanMemoryBudget& operator=(const VulkanMemoryBudget&) = delete;
+    
+    bool init(VulkanAllocator& allocator, VulkanUploader& uploader, VulkanDeletionQueue& deletion, vk::raii::Device& lDev);
+    
+    // textures are held weakly, whoever owns them decides when they go away
+    void track(const std::shared_ptr<VulkanTexture>& texture);
+    
+    // call once per frame before recording, evictions are recorded into the upload batch
+    void update(uint64_t frameNumber);
+    
+    const std::vector<VulkanHeapBudget>& getHeaps() const { return m_heaps; }
+  
+  private:
+    
+    void evict(vk::DeviceSize bytes);
+    void logHeaps() const;
+    
+    VulkanAllocator* m_allocator{nullptr};
+    VulkanUploader* m_uploader{nullptr};
+    VulkanDeletionQueue* m_deletion{nullptr};
+    vk::raii::Device* m_lDev{nullptr};
+    
+    std::vector<std::weak_ptr<VulkanTexture>> m_textures;
+    std::vector<VulkanHeapBudget> m_heaps;
+    
+    UploadTicket m_evictTicket{0};
+    uint64_t m_evictFrame{0};
+    bool m_exhausted{false}; // everything evictable is already at its smallest
+    std::chrono::steady_clock::time_point m_lastLog{};
+    
+  };
+  
+}; //V
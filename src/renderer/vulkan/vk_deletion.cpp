@@ -0,0 +1,48 @@
+#include "vk_deletion.hpp"
+
+namespace V {
+  
+  VulkanDeletionQueue::VulkanDeletionQueue() {
+    
+  }
+  
+  VulkanDeletionQueue::~VulkanDeletionQueue() {
+    // callbacks may point into objects already gone, only drop what the entries hold
+    m_entries.clear();
+  }
+  
+  bool VulkanDeletionQueue::init(VulkanUploader& uploader) {
+    m_uploader = &uploader;
+    return true;
+  }
+  
+  void VulkanDeletionQueue::defer(std::function<void()>&& fn) {
+    m_entries.push_back({
+      .frame = m_frame,
+      .ticket = m_uploader->getRecordedTicket(),
+      .release = std::move(fn)
+    });
+  }
+  
+  void VulkanDeletionQueue::beginFrame(uint64_t frame) {
+    m_frame = frame;
+    
+    while(!m_entries.empty()) {
+      auto& entry = m_entries.front();
+      if(entry.frame + MAX_FRAMES_IN_FLIGHT > frame || !m_uploader->isDone(entry.ticket)) break;
+      
+      auto release = std::move(entry.release);
+      m_entries.pop_front();
+      release();
+    }
+  }
+  
+  void VulkanDeletionQueue::flush() {
+    while(!m_entries.empty()) {
+      auto release = std::move(m_entries.front().release);
+      m_entries.pop_front();
+      release();
+    }
+  }
+  
+}; //V
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "vk_upload.hpp"
+
+namespace V {
+  
+  // releases resources once every frame that may reference them has retired, instead of waiting for the device;
+  // an entry is tagged with the frame being recorded and the upload batch recorded so far
+  class VulkanDeletionQueue {
+  public:
+    
+    VulkanDeletionQueue();
+    ~VulkanDeletionQueue();
+    
+    VulkanDeletionQueue(const VulkanDeletionQueue&) = delete;
+    VulkanDeletionQueue& operator=(const VulkanDeletionQueue&) = delete;
+    
+    bool init(VulkanUploader& uploader);
+    
+    // takes ownership, the resources are destroyed on retirement
+    template<typename... T>
+    void push(T&&... resources) {
+      auto held = std::make_shared<std::tuple<std::decay_t<T>...>>(std::move(resources)...);
+      defer([held = std::move(held)]() mutable { held.reset(); });
+    }
+    
+    // runs fn on retirement, entries retire in the order they were queued
+    void defer(std::function<void()>&& fn);
+    
+    // call after waiting for the fence of `frame`'s slot: frames up to frame - MAX_FRAMES_IN_FLIGHT are done
+    void beginFrame(uint64_t frame);
+    // releases everything regardless of tags, the device must be idle
+    void flush();
+    
+    size_t getPending() const { return m_entries.size(); }
+  
+  private:
+    
+    struct Entry {
+      uint64_t frame{0};
+      UploadTicket ticket{0};
+      std::function<void()> release;
+    };
+    
+    VulkanUploader* m_uploader{nullptr};
+    std::deque<Entry> m_entries;
+    uint64_t m_frame{0};
+    
+  };
+  
+}; //V
@@ -0,0 +1,295 @@
+#include "vk_geometry.hpp"
+
+namespace V {
+  
+  VulkanGeometryPool::VulkanGeometryPool() {
+    
+  }
+  
+  VulkanGeometryPool::~VulkanGeometryPool() {
+    
+  }
+  
+  bool VulkanGeometryPool::init(
+    VulkanAllocator& allocator,
+    vk::raii::Device& lDev,
+    VulkanUploader& uploader,
+    VulkanDeletionQueue& deletion,
+    uint32_t vertCapacity,
+    uint32_t indCapacity
+  ) {
+    
+    m_allocator = &allocator;
+    m_lDev = &lDev;
+    m_uploader = &uploader;
+    m_deletion = &deletion;
+    
+    // stream i of a vertex arena is bound at binding i
+    for(uint32_t i = 0; i < VERTEX_LAYOUT_COUNT; ++i) {
+      auto& arena = m_vertArenas[i];
+      arena.streams.resize(2);
+      arena.streams[0].stride = getPositionStride(static_cast<VertexLayout>(i));
+      arena.streams[0].usage = vk::BufferUsageFlagBits::eVertexBuffer;
+      arena.streams[1].stride = sizeof(VertexAttributes);
+      arena.streams[1].usage = vk::BufferUsageFlagBits::eVertexBuffer;
+    }
+    
+    m_indArenas[0].streams.resize(1);
+    m_indArenas[0].streams[0].stride = sizeof(uint16_t);
+    m_indArenas[0].streams[0].usage = vk::BufferUsageFlagBits::eIndexBuffer;
+    m_indArenas[1].streams.resize(1);
+    m_indArenas[1].streams[0].stride = sizeof(uint32_t);
+    m_indArenas[1].streams[0].usage = vk::BufferUsageFlagBits::eIndexBuffer;
+    
+    for(auto& arena : m_vertArenas) {
+      if(!createStreams(arena, vertCapacity)) {
+        Logger::error("Failed to create geometry pool");
+        return false;
+      }
+      arena.ranges.init(vertCapacity);
+    }
+    
+    for(auto& arena : m_indArenas) {
+      if(!createStreams(arena, indCapacity)) {
+        Logger::error("Failed to create geometry pool");
+        return false;
+      }
+      arena.ranges.init(indCapacity);
+    }
+    
+    return true;
+  }
+  
+  bool VulkanGeometryPool::createStreams(Arena& arena, uint32_t capacity) {
+    
+    for(auto& stream : arena.streams) {
+      if(!createBuf(
+        capacity * stream.stride,
+        stream.usage | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        stream.buf,
+        stream.alloc,
+        *m_allocator,
+        *m_lDev
+      )) return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanGeometryPool::upload(Arena& arena, uint32_t offset, const std::vector<std::span<const std::byte>>& data, uint32_t count) {
+    
+    // zero-sized copies are not valid Vulkan
+    if(count == 0) return true;
+
+    for(size_t i = 0; i < arena.streams.size(); ++i) {
+      const auto& stream = arena.streams[i];
+      if(!m_uploader->uploadBuf(data[i].data(), count * stream.stride, stream.buf, offset * stream.stride)) return false;
+    }
+    
+    return true;
+  }
+  
+  std::optional<GeometryHandle> VulkanGeometryPool::alloc(const GeometryView& geometry) {
+    
+    VertexLayout layout = geometry.layout;
+    vk::IndexType indexType = geometry.indexType;
+    uint32_t vertCount = geometry.vertexCount;
+    uint32_t indCount = geometry.indexCount;
+    
+    if(  geometry.positions.size() != vertCount * getPositionStride(layout)
+      || geometry.attributes.size() != vertCount * sizeof(VertexAttributes)
+      || geometry.indices.size() != indCount * getIndexSize(indexType)
+    ) {
+      Logger::error("Geometry pool: data does not match {} vertices / {} indices", vertCount, indCount);
+      return std::nullopt;
+    }
+    
+    auto& vertArena = getArena(layout);
+    auto& indArena = getArena(indexType);
+    
+    auto vertOff = vertArena.ranges.alloc(vertCount);
+    if(!vertOff) {
+      // grow: repack into buffers big enough for everything plus this mesh
+      uint32_t cap = std::max(vertArena.ranges.getCapacity() * 2, vertArena.ranges.getUsed() + vertCount);
+      Logger::info("Geometry pool full, growing {} vertices to {}", layout == VertexLayout::eSkinned ? "skinned" : "static", cap);
+      
+      if(!rebuild(vertArena, cap)) return std::nullopt;
+      vertOff = vertArena.ranges.alloc(vertCount);
+    }
+    
+    auto indOff = indArena.ranges.alloc(indCount);
+    if(!indOff) {
+      uint32_t cap = std::max(indArena.ranges.getCapacity() * 2, indArena.ranges.getUsed() + indCount);
+      Logger::info("Geometry pool full, growing {} indices to {}", vk::to_string(indexType), cap);
+      
+      if(!rebuild(indArena, cap)) {
+        if(vertOff) vertArena.ranges.free(*vertOff, vertCount);
+        return std::nullopt;
+      }
+      indOff = indArena.ranges.alloc(indCount);
+    }
+    
+    if(!vertOff || !indOff) {
+      Logger::error("Geometry pool: failed to allocate {} vertices / {} indices", vertCount, indCount);
+      if(vertOff) vertArena.ranges.free(*vertOff, vertCount);
+      if(indOff) indArena.ranges.free(*indOff, indCount);
+      return std::nullopt;
+    }
+    
+    if(!upload(vertArena, *vertOff, {geometry.positions, geometry.attributes}, vertCount) || !upload(indArena, *indOff, {geometry.indices}, indCount)) {
+      vertArena.ranges.free(*vertOff, vertCount);
+      indArena.ranges.free(*indOff, indCount);
+      return std::nullopt;
+    }
+    
+    GeometryHandle handle;
+    if(!m_freeHandles.empty()) {
+      handle = m_freeHandles.back();
+      m_freeHandles.pop_back();
+    } else {
+      handle = static_cast<GeometryHandle>(m_ranges.size());
+      m_ranges.emplace_back();
+    }
+    
+    m_ranges[handle] = GeometryRange{
+      .layout = layout,
+      .indexType = indexType,
+      .vertexOffset = *vertOff,
+      .vertexCount = vertCount,
+      .firstIndex = *indOff,
+      .indexCount = indCount,
+      .live = true
+    };
+    
+    return handle;
+  }
+  
+  void VulkanGeometryPool::free(GeometryHandle handle) {
+    if(handle >= m_ranges.size() || !m_ranges[handle].live) return;
+    
+    GeometryRange range = m_ranges[handle];
+    m_ranges[handle].live = false;
+    m_freeHandles.push_back(handle);
+    
+    // a rebuild before retirement already left the range behind, it only repacks live ones
+    uint32_t vertGen = getArena(range.layout).generation;
+    uint32_t indGen = getArena(range.indexType).generation;
+    m_deletion->defer([this, range, vertGen, indGen]() {
+      auto& vertArena = getArena(range.layout);
+      auto& indArena = getArena(range.indexType);
+      if(vertArena.generation == vertGen) vertArena.ranges.free(range.vertexOffset, range.vertexCount);
+      if(indArena.generation == indGen) indArena.ranges.free(range.firstIndex, range.indexCount);
+    });
+  }
+  
+  void VulkanGeometryPool::bind(vk::raii::CommandBuffer& cmdBuf, const GeometryRange& range, GeometryBindState& state) {
+    
+    if(state.layout != range.layout) {
+      const auto& arena = getArena(range.layout);
+      for(uint32_t i = 0; i < arena.streams.size(); ++i) {
+        cmdBuf.bindVertexBuffers(i, *arena.streams[i].buf, {0});
+      }
+      state.layout = range.layout;
+    }
+    
+    if(state.indexType != range.indexType) {
+      cmdBuf.bindIndexBuffer(*getArena(range.indexType).streams[0].buf, 0, range.indexType);
+      state.indexType = range.indexType;
+    }
+  }
+  
+  bool VulkanGeometryPool::compact() {
+    bool moved = false;
+    
+    for(auto& arena : m_vertArenas) {
+      if(arena.ranges.getFreeBlockCount() > 1) {
+        moved |= rebuild(arena, arena.ranges.getCapacity());
+      }
+    }
+    for(auto& arena : m_indArenas) {
+      if(arena.ranges.getFreeBlockCount() > 1) {
+        moved |= rebuild(arena, arena.ranges.getCapacity());
+      }
+    }
+    
+    return moved;
+  }
+  
+  bool VulkanGeometryPool::rebuild(Arena& arena, uint32_t capacity) {
+    
+    Arena fresh;
+    for(const auto& stream : arena.streams) {
+      auto& s = fresh.streams.emplace_back();
+      s.stride = stream.stride;
+      s.usage = stream.usage;
+    }
+    if(!createStreams(fresh, capacity)) {
+      Logger::error("Failed to rebuild geometry pool");
+      return false;
+    }
+    fresh.ranges.init(capacity);
+    
+    // live ranges of this arena, as (offset, count) references into m_ranges
+    std::vector<std::pair<uint32_t*, uint32_t>> live;
+    for(auto& range : m_ranges) {
+      if(!range.live) continue;
+      if(&getArena(range.layout) == &arena) {
+        if(range.vertexCount == 0) continue;
+        live.emplace_back(&range.vertexOffset, range.vertexCount);
+      } else if(&getArena(range.indexType) == &arena) {
+        if(range.indexCount == 0) continue;
+        live.emplace_back(&range.firstIndex, range.indexCount);
+      }
+    }
+    // keep the old relative order so the copies stream front to back
+    std::ranges::sort(live, {}, [](const auto& r) { return *r.first; });
+    
+    std::vector<std::vector<vk::BufferCopy>> copies(arena.streams.size());
+    std::vector<uint32_t> newOffsets;
+    newOffsets.reserve(live.size());
+    for(auto& [offset, count] : live) {
+      uint32_t newOff = *fresh.ranges.alloc(count);
+      for(size_t i = 0; i < arena.streams.size(); ++i) {
+        vk::DeviceSize stride = arena.streams[i].stride;
+        copies[i].push_back(vk::BufferCopy(*offset * stride, newOff * stride, count * stride));
+      }
+      newOffsets.push_back(newOff);
+    }
+    
+    // uploads still pending in the open batch must land in the old buffers before they are read
+    m_uploader->transferBarrier();
+    for(size_t i = 0; i < arena.streams.size(); ++i) {
+      if(!m_uploader->copyRegions(arena.streams[i].buf, fresh.streams[i].buf, copies[i])) {
+        Logger::error("Failed to record the geometry pool copy");
+        return false;
+      }
+    }
+    // ranges only move once the copies are recorded, a failed rebuild leaves the arena as it was
+    for(size_t i = 0; i < live.size(); ++i) {
+      *live[i].first = newOffsets[i];
+    }
+    for(auto& stream : arena.streams) {
+      // read by the copy and by frames in flight
+      m_deletion->push(std::move(stream.buf), std::move(stream.alloc));
+    }
+    m_uploader->flush();
+    
+    arena.streams = std::move(fresh.streams);
+    arena.ranges = std::move(fresh.ranges);
+    ++arena.generation;
+    
+    return true;
+  }
+  
+  void VulkanGeometryPool::logStats() const {
+    Logger::info("Geometry pool: {} / {} static vertices, {} / {} skinned vertices, {} / {} 16-bit and {} / {} 32-bit indices, {} meshes",
+      m_vertArenas[0].ranges.getUsed(), m_vertArenas[0].ranges.getCapacity(),
+      m_vertArenas[1].ranges.getUsed(), m_vertArenas[1].ranges.getCapacity(),
+      m_indArenas[0].ranges.getUsed(), m_indArenas[0].ranges.getCapacity(),
+      m_indArenas[1].ranges.getUsed(), m_indArenas[1].ranges.getCapacity(),
+      m_ranges.size() - m_freeHandles.size()
+    );
+  }
+  
+}; //V
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "vk_deletion.hpp"
+#include "vk_vertex.hpp"
+
+#include <map>
+#include <cstring>
+
+namespace V {
+  
+  // first-fit free list over [0, capacity), units are whatever the caller stores (vertices, indices)
+  class RangeAllocator {
+  public:
+    
+    void init(uint32_t capacity) {
+      m_free.clear();
+      m_capacity = capacity;
+      m_used = 0;
+      if(capacity > 0) m_free[0] = capacity;
+    }
+    
+    std::optional<uint32_t> alloc(uint32_t count) {
+      // empty geometry takes no space, any offset is valid for it
+      if(count == 0) return 0u;
+      
+      for(auto it = m_free.begin(); it != m_free.end(); ++it) {
+        if(it->second < count) continue;
+        
+        uint32_t offset = it->first;
+        uint32_t rest = it->second - count;
+        m_free.erase(it);
+        if(rest > 0) m_free[offset + count] = rest;
+        
+        m_used += count;
+        return offset;
+      }
+      
+      return std::nullopt;
+    }
+    
+    void free(uint32_t offset, uint32_t count) {
+      if(count == 0) return;
+      m_used -= count;
+      
+      auto next = m_free.lower_bound(offset);
+      if(next != m_free.begin()) {
+        auto prev = std::prev(next);
+        if(prev->first + prev->second == offset) {
+          offset = prev->first;
+          count += prev->second;
+          m_free.erase(prev);
+        }
+      }
+      if(next != m_free.end() && offset + count == next->first) {
+        count += next->second;
+        m_free.erase(next);
+      }
+      
+      m_free[offset] = count;
+    }
+    
+    uint32_t getCapacity() const { return m_capacity; }
+    uint32_t getUsed() const { return m_used; }
+    size_t getFreeBlockCount() const { return m_free.size(); }
+  
+  private:
+    
+    std::map<uint32_t, uint32_t> m_free; // offset -> count
+    uint32_t m_capacity{0};
+    uint32_t m_used{0};
+    
+  };
+  
+  using GeometryHandle = uint32_t;
+  
+  // meshes with at most 65535 vertices are stored with 16-bit indices
+  inline vk::IndexType getIndexType(uint32_t vertCount) {
+    return vertCount <= std::numeric_limits<uint16_t>::max() ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+  }
+  
+  inline vk::DeviceSize getIndexSize(vk::IndexType type) {
+    return type == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+  }
+  
+  inline std::vector<std::byte> packIndices(const std::vector<uint32_t>& inds, vk::IndexType type) {
+    std::vector<std::byte> out(inds.size() * getIndexSize(type));
+    if(type == vk::IndexType::eUint16) {
+      auto* dst = reinterpret_cast<uint16_t*>(out.data());
+      for(size_t i = 0; i < inds.size(); ++i) dst[i] = static_cast<uint16_t>(inds[i]);
+    } else {
+      std::memcpy(out.data(), inds.data(), out.size());
+    }
+    return out;
+  }
+  
+  // GPU-ready data of one mesh: both vertex streams packed in its layout, indices in its index type
+  struct GeometryView {
+    VertexLayout layout{VertexLayout::eStatic};
+    vk::IndexType indexType{vk::IndexType::eUint32};
+    uint32_t vertexCount{0};
+    uint32_t indexCount{0};
+    std::span<const std::byte> positions;
+    std::span<const std::byte> attributes;
+    std::span<const std::byte> indices;
+  };
+  
+  struct GeometryRange {
+    VertexLayout layout{VertexLayout::eStatic};
+    vk::IndexType indexType{vk::IndexType::eUint32};
+    uint32_t vertexOffset{0};
+    uint32_t vertexCount{0};
+    uint32_t firstIndex{0};
+    uint32_t indexCount{0};
+    bool live{false};
+  };
+  
+  // what is currently bound on a command buffer, so consecutive draws only rebind what changes
+  struct GeometryBindState {
+    std::optional<VertexLayout> layout;
+    std::optional<vk::IndexType> indexType;
+  };
+  
+  // every mesh lives in the device-local vertex buffers of its layout and the index buffer of its index type,
+  // draws address their range through vertexOffset / firstIndex
+  class VulkanGeometryPool {
+  public:
+    
+    VulkanGeometryPool();
+    ~VulkanGeometryPool();
+    
+    VulkanGeometryPool(const VulkanGeometryPool&) = delete;
+    VulkanGeometryPool& operator=(const VulkanGeometryPool&) = delete;
+    
+    bool init(
+      VulkanAllocator& allocator,
+      vk::raii::Device& lDev,
+      VulkanUploader& uploader,
+      VulkanDeletionQueue& deletion,
+      uint32_t vertCapacity = GEOMETRY_POOL_VERTICES,
+      uint32_t indCapacity = GEOMETRY_POOL_INDICES
+    );
+    
+    // the data is copied straight into staging, the view only has to live through the call
+    std::optional<GeometryHandle> alloc(const GeometryView& geometry);
+    // the handle is reusable right away, the range itself only once frames in flight are done drawing it
+    void free(GeometryHandle handle);
+    
+    const GeometryRange& get(GeometryHandle handle) const { return m_ranges[handle]; }
+    
+    void bind(vk::raii::CommandBuffer& cmdBuf, const GeometryRange& range, GeometryBindState& state);
+    
+    // repack live ranges to the front of fresh buffers, returns false if nothing moved
+    bool compact();
+    void logStats() const;
+    
+  private:
+    
+    struct Stream {
+      vk::DeviceSize stride{0};
+      vk::BufferUsageFlags usage;
+      vk::raii::Buffer buf{nullptr};
+      VulkanAllocation alloc{nullptr};
+    };
+    
+    // one range allocator addressing every stream of the arena with the same element index
+    struct Arena {
+      RangeAllocator ranges;
+      std::vector<Stream> streams;
+      uint32_t generation{0}; // bumped by rebuild, deferred frees from before it are void
+    };
+    
+    bool createStreams(Arena& arena, uint32_t capacity);
+    bool rebuild(Arena& arena, uint32_t capacity);
+    bool upload(Arena& arena, uint32_t offset, const std::vector<std::span<const std::byte>>& data, uint32_t count);
+    
+    Arena& getArena(VertexLayout layout) { return m_vertArenas[static_cast<size_t>(layout)]; }
+    Arena& getArena(vk::IndexType type) { return m_indArenas[type == vk::IndexType::eUint16 ? 0 : 1]; }
+    
+    VulkanAllocator* m_allocator{nullptr};
+    vk::raii::Device* m_lDev{nullptr};
+    VulkanUploader* m_uploader{nullptr};
+    VulkanDeletionQueue* m_deletion{nullptr};
+    
+    std::array<Arena, VERTEX_LAYOUT_COUNT> m_vertArenas;
+    std::array<Arena, 2> m_indArenas; // uint16, uint32
+    
+    std::vector<GeometryRange> m_ranges;
+    std::vector<GeometryHandle> m_freeHandles;
+    
+  };
+  
+}; //V
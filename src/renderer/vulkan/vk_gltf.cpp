@@ -0,0 +1,575 @@
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <unordered_map>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "vk_model_asset.hpp"
+
+namespace V {
+  
+  namespace {
+    
+    // joint node -> bone id, the joints of every skin share one table
+    using JointMapping = std::unordered_map<const cgltf_node*, uint32_t>;
+    
+    struct GltfPrimitive {
+      const cgltf_primitive* prim{nullptr};
+      const cgltf_skin* skin{nullptr};
+      std::string name;
+      uint32_t material{0};
+      glm::mat4 transform{1.f}; // node to model space, baked into static meshes
+    };
+    
+    // cgltf_validate() does not check attribute types, one of the wrong shape is treated as missing
+    const cgltf_accessor* findAttribute(const cgltf_primitive& prim, cgltf_attribute_type type, cgltf_type expected) {
+      for(cgltf_size i = 0; i < prim.attributes_count; ++i) {
+        const cgltf_attribute& attr = prim.attributes[i];
+        if(attr.type != type || attr.index != 0) continue;
+        
+        if(attr.data->type != expected) {
+          Logger::warn("glTF: attribute {} has the wrong type, ignored", attr.name ? attr.name : "");
+          return nullptr;
+        }
+        return attr.data;
+      }
+      return nullptr;
+    }
+    
+    // the whole accessor in one pass, normalized integers and sparse data resolved by cgltf
+    std::vector<float> unpackFloats(const cgltf_accessor* accessor) {
+      std::vector<float> res(cgltf_accessor_unpack_floats(accessor, nullptr, 0));
+      cgltf_accessor_unpack_floats(accessor, res.data(), res.size());
+      return res;
+    }
+    
+    // glTF URIs are percent-encoded
+    std::string decodeUri(const char* uri) {
+      std::string res = uri;
+      cgltf_decode_uri(res.data());
+      res.resize(std::strlen(res.c_str()));
+      return res;
+    }
+    
+    // embedded images are written once next to the model and then load like any other texture file,
+    // cooking and streaming included: Fox.glb -> Fox.glb.image0.png. Returns the file name, empty on failure
+    std::string extractImage(const cgltf_data* data, const cgltf_image& image, const std::string& modelPath) {
+      
+      std::span<const std::byte> bytes;
+      std::vector<std::byte> decoded;
+      if(image.buffer_view) {
+        const auto* view = static_cast<const std::byte*>(cgltf_buffer_view_data(image.buffer_view));
+        if(!view) return {};
+        bytes = {view, image.buffer_view->size};
+      } else {
+        // data:<mime>;base64,<payload>
+        const char* payload = image.uri ? std::strchr(image.uri, ',') : nullptr;
+        if(!payload || !std::strstr(image.uri, ";base64")) return {};
+        ++payload;
+        
+        size_t len = std::strlen(payload);
+        while(len > 0 && payload[len - 1] == '=') --len;
+        cgltf_options options{};
+        void* out = nullptr;
+        if(cgltf_load_buffer_base64(&options, len * 3 / 4, payload, &out) != cgltf_result_success) return {};
+        decoded.assign(static_cast<const std::byte*>(out), static_cast<const std::byte*>(out) + len * 3 / 4);
+        std::free(out);
+        bytes = decoded;
+      }
+      if(bytes.size() < 4) return {};
+      
+      // stb sniffs the contents, the extension only has to look right
+      bool png = bytes[0] == std::byte{0x89} && bytes[1] == std::byte{'P'};
+      std::string path = fmt::format("{}.image{}{}", modelPath, &image - data->images, png ? ".png" : ".jpg");
+      std::string name = std::filesystem::path(path).filename().string();
+      
+      std::error_code ec;
+      if(  std::filesystem::exists(path, ec)
+        && std::filesystem::last_write_time(path, ec) >= std::filesystem::last_write_time(modelPath, ec)
+      ) return name;
+      
+      // written aside and renamed, a crash mid-write never leaves half an image behind
+      std::string tmpPath = path + ".tmp";
+      {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if(!file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+          Logger::error("glTF: failed to write embedded image {}", tmpPath);
+          return {};
+        }
+      }
+      std::filesystem::rename(tmpPath, path, ec);
+      if(ec) {
+        Logger::error("glTF: failed to write embedded image {}: {}", path, ec.message());
+        std::filesystem::remove(tmpPath, ec);
+        return {};
+      }
+      
+      Logger::info("glTF: extracted embedded image {}", path);
+      return name;
+    }
+    
+    void generateNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+      for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Vertex& a = vertices[indices[i]];
+        Vertex& b = vertices[indices[i + 1]];
+        Vertex& c = vertices[indices[i + 2]];
+        // area weighted
+        glm::vec3 n = glm::cross(b.pos - a.pos, c.pos - a.pos);
+        a.clr += n;
+        b.clr += n;
+        c.clr += n;
+      }
+      for(auto& v : vertices) {
+        float len = glm::length(v.clr);
+        v.clr = len > 0.f ? v.clr / len : glm::vec3(0.f, 0.f, 1.f);
+      }
+    }
+    
+    // only reads the parsed document and the joint mapping, safe to run for several primitives at once
+    ConvertedMesh convertPrimitive(const GltfPrimitive& p, const JointMapping& joints) {
+      const cgltf_primitive& prim = *p.prim;
+      
+      // checked by collectPrimitives()
+      const cgltf_accessor* posAcc = findAttribute(prim, cgltf_attribute_type_position, cgltf_type_vec3);
+      size_t count = posAcc->count;
+      
+      // attributes not matching the vertex count are dropped like the wrongly typed ones
+      auto findOptional = [&](cgltf_attribute_type type, cgltf_type expected) -> const cgltf_accessor* {
+        const cgltf_accessor* acc = findAttribute(prim, type, expected);
+        return acc && acc->count == count ? acc : nullptr;
+      };
+      const cgltf_accessor* normalAcc = findOptional(cgltf_attribute_type_normal, cgltf_type_vec3);
+      const cgltf_accessor* uvAcc = findOptional(cgltf_attribute_type_texcoord, cgltf_type_vec2);
+      const cgltf_accessor* jointsAcc = p.skin ? findOptional(cgltf_attribute_type_joints, cgltf_type_vec4) : nullptr;
+      const cgltf_accessor* weightsAcc = p.skin ? findOptional(cgltf_attribute_type_weights, cgltf_type_vec4) : nullptr;
+      bool skinned = jointsAcc && weightsAcc;
+      
+      std::vector<Vertex> vertices(count);
+      
+      //vertices==================================================
+      auto positions = unpackFloats(posAcc);
+      for(size_t i = 0; i < count; ++i) {
+        vertices[i].pos = glm::make_vec3(&positions[i * 3]);
+      }
+      
+      if(normalAcc) {
+        auto normals = unpackFloats(normalAcc);
+        for(size_t i = 0; i < count; ++i) vertices[i].clr = glm::make_vec3(&normals[i * 3]);
+      }
+      
+      if(uvAcc) {
+        // top-left origin like Vulkan, no flip
+        auto uvs = unpackFloats(uvAcc);
+        for(size_t i = 0; i < count; ++i) vertices[i].texCoord = glm::make_vec2(&uvs[i * 2]);
+      }
+      
+      if(skinned) {
+        auto weights = unpackFloats(weightsAcc);
+        for(size_t i = 0; i < count; ++i) {
+          cgltf_uint ids[4] = {};
+          cgltf_accessor_read_uint(jointsAcc, i, ids, 4);
+          
+          float total = 0.f;
+          for(int k = 0; k < MAX_BONES_PER_VERTEX; ++k) {
+            float w = weights[i * 4 + k];
+            if(w <= 0.f || ids[k] >= p.skin->joints_count) continue;
+            auto it = joints.find(p.skin->joints[ids[k]]);
+            if(it == joints.end()) continue;
+            
+            vertices[i].boneIDs[k] = static_cast<int>(it->second);
+            vertices[i].weights[k] = w;
+            total += w;
+          }
+          if(total > 0.f) vertices[i].weights /= total;
+        }
+      }
+      //vertices==================================================
+      
+      //indices==================================================
+      // cgltf_validate() already checked every index against the vertex count
+      std::vector<uint32_t> indices;
+      if(prim.indices) {
+        indices.resize(prim.indices->count);
+        for(size_t i = 0; i < indices.size(); ++i) {
+          indices[i] = static_cast<uint32_t>(cgltf_accessor_read_index(prim.indices, i));
+        }
+      } else {
+        indices.resize(count);
+        for(size_t i = 0; i < count; ++i) indices[i] = static_cast<uint32_t>(i);
+      }
+      //indices==================================================
+      
+      if(!normalAcc) generateNormals(vertices, indices);
+      
+      // skinned vertices stay in bind space, the skeleton places them
+      if(!skinned && p.transform != glm::mat4(1.f)) {
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(p.transform)));
+        for(auto& v : vertices) {
+          v.pos = glm::vec3(p.transform * glm::vec4(v.pos, 1.f));
+          v.clr = glm::normalize(normalMatrix * v.clr);
+        }
+        // a mirroring transform flips the winding
+        if(glm::determinant(glm::mat3(p.transform)) < 0.f) {
+          for(size_t i = 0; i + 2 < indices.size(); i += 3) std::swap(indices[i + 1], indices[i + 2]);
+        }
+      }
+      
+      auto layout = skinned ? VertexLayout::eSkinned : VertexLayout::eStatic;
+      return convertVertices(p.name, p.material, layout, vertices, indices);
+    }
+    
+    void collectPrimitives(
+      const cgltf_data* data,
+      const cgltf_node* node,
+      std::vector<GltfPrimitive>& prims,
+      bool& needsDefaultMaterial
+    ) {
+      
+      if(node->mesh) {
+        const cgltf_mesh* mesh = node->mesh;
+        std::string meshName = mesh->name ? mesh->name : fmt::format("mesh_{}", mesh - data->meshes);
+        
+        float world[16];
+        cgltf_node_transform_world(node, world);
+        
+        for(cgltf_size i = 0; i < mesh->primitives_count; ++i) {
+          const cgltf_primitive& prim = mesh->primitives[i];
+          if(prim.type != cgltf_primitive_type_triangles || !findAttribute(prim, cgltf_attribute_type_position, cgltf_type_vec3)) {
+            Logger::warn("glTF: {} primitive {} is not a triangle list with VEC3 positions, skipped", meshName, i);
+            continue;
+          }
+          if(prim.indices && prim.indices->type != cgltf_type_scalar) {
+            Logger::warn("glTF: {} primitive {} has non-scalar indices, skipped", meshName, i);
+            continue;
+          }
+          
+          GltfPrimitive p{
+            .prim = &prim,
+            .skin = node->skin,
+            .name = mesh->primitives_count > 1 ? fmt::format("{}_{}", meshName, i) : meshName,
+            .material = prim.material ? static_cast<uint32_t>(prim.material - data->materials) : static_cast<uint32_t>(data->materials_count),
+            .transform = glm::make_mat4(world)
+          };
+          needsDefaultMaterial |= !prim.material;
+          prims.push_back(std::move(p));
+        }
+      }
+      
+      for(cgltf_size i = 0; i < node->children_count; ++i) {
+        collectPrimitives(data, node->children[i], prims, needsDefaultMaterial);
+      }
+    }
+    
+    // bone ids in skin and joint order, before the primitives fan out
+    bool collectJoints(const cgltf_data* data, JointMapping& joints, std::vector<BoneAsset>& bones) {
+      for(cgltf_size s = 0; s < data->skins_count; ++s) {
+        const cgltf_skin& skin = data->skins[s];
+        for(cgltf_size j = 0; j < skin.joints_count; ++j) {
+          const cgltf_node* node = skin.joints[j];
+          if(joints.contains(node)) continue;
+          
+          uint32_t boneIndex = static_cast<uint32_t>(bones.size());
+          if (boneIndex + 1 > MAX_BONES) {
+            Logger::error("FATAL: Number of bones ({}) exceeds MAX_BONES ({}). Increase MAX_BONES in vk_buffer.hpp and the shader.",
+                                      boneIndex + 1, MAX_BONES);
+            return false;
+          }
+          
+          glm::mat4 offset(1.f);
+          if(skin.inverse_bind_matrices) {
+            float m[16];
+            cgltf_accessor_read_float(skin.inverse_bind_matrices, j, m, 16);
+            offset = glm::make_mat4(m);
+          }
+          
+          bones.push_back({
+            .name = node->name ? node->name : fmt::format("joint_{}", node - data->nodes),
+            .offset = offset
+          });
+          joints[node] = boneIndex;
+        }
+      }
+      
+      return true;
+    }
+    
+    // the parsed document with every buffer resolved; members go in reverse order, the data before the mappings
+    struct GltfFile {
+      MappedFile file;
+      std::vector<MappedFile> buffers;
+      std::unique_ptr<cgltf_data, decltype(&cgltf_free)> data{nullptr, &cgltf_free};
+    };
+    
+    bool openGltf(const std::string& path, GltfFile& out) {
+      
+      if(!out.file.open(path)) {
+        Logger::error("glTF: failed to open {}", path);
+        return false;
+      }
+      
+      cgltf_options options{};
+      cgltf_data* parsed = nullptr;
+      if(cgltf_result res = cgltf_parse(&options, out.file.data(), out.file.size(), &parsed); res != cgltf_result_success) {
+        Logger::error("glTF: failed to parse {} (error {})", path, static_cast<int>(res));
+        return false;
+      }
+      out.data.reset(parsed);
+      cgltf_data* data = out.data.get();
+      
+      // external .bin files are mapped instead of read; a GLB's own chunk and data: URIs are left to cgltf
+      std::filesystem::path dir = std::filesystem::path(path).parent_path();
+      out.buffers.reserve(data->buffers_count);
+      for(cgltf_size i = 0; i < data->buffers_count; ++i) {
+        cgltf_buffer& buffer = data->buffers[i];
+        if(!buffer.uri || std::strncmp(buffer.uri, "data:", 5) == 0) continue;
+        
+        std::string bufferPath = (dir / decodeUri(buffer.uri)).string();
+        MappedFile& mapped = out.buffers.emplace_back();
+        if(!mapped.open(bufferPath) || mapped.size() < buffer.size) {
+          Logger::error("glTF: buffer {} is missing or too short", bufferPath);
+          return false;
+        }
+        buffer.data = const_cast<std::byte*>(mapped.data());
+        buffer.data_free_method = cgltf_data_free_method_none;
+      }
+      
+      if(  cgltf_load_buffers(&options, data, path.c_str()) != cgltf_result_success
+        || cgltf_validate(data) != cgltf_result_success
+      ) {
+        Logger::error("glTF: {} is invalid or references missing data", path);
+        return false;
+      }
+      
+      return true;
+    }
+    
+    std::vector<const cgltf_node*> getRoots(const cgltf_data* data) {
+      const cgltf_scene* scene = data->scene ? data->scene : (data->scenes_count > 0 ? &data->scenes[0] : nullptr);
+      std::vector<const cgltf_node*> roots;
+      if(scene) {
+        roots.assign(scene->nodes, scene->nodes + scene->nodes_count);
+      } else {
+        for(cgltf_size i = 0; i < data->nodes_count; ++i) {
+          if(!data->nodes[i].parent) roots.push_back(&data->nodes[i]);
+        }
+      }
+      return roots;
+    }
+    
+    // keys of one channel as the next node of the track, nullptr for a node the clip leaves alone.
+    // step keys are doubled at each change so linear sampling holds them; cubic splines keep their values, not the tangents
+    template<typename T>
+    float appendChannel(AnimTrack<T>& track, const cgltf_animation_sampler* sampler) {
+      track.first.push_back(static_cast<uint32_t>(track.times.size()));
+      if(!sampler) return 0.f;
+      
+      constexpr cgltf_size components = sizeof(T) / sizeof(float);
+      bool cubic = sampler->interpolation == cgltf_interpolation_type_cubic_spline;
+      bool step = sampler->interpolation == cgltf_interpolation_type_step;
+      cgltf_size keys = sampler->input->count;
+      
+      float end = 0.f;
+      for(cgltf_size k = 0; k < keys; ++k) {
+        float time = 0.f;
+        float v[4] = {};
+        cgltf_accessor_read_float(sampler->input, k, &time, 1);
+        cgltf_accessor_read_float(sampler->output, cubic ? k * 3 + 1 : k, v, components);
+        
+        T value;
+        if constexpr(std::is_same_v<T, glm::quat>) value = glm::quat(v[3], v[0], v[1], v[2]); // stored xyzw
+        else value = glm::make_vec3(v);
+        
+        if(step && k > 0) {
+          track.times.push_back(time);
+          track.values.push_back(track.values.back());
+        }
+        track.times.push_back(time);
+        track.values.push_back(value);
+        end = std::max(end, time);
+      }
+      
+      return end;
+    }
+    
+    void closeTrack(auto& track) {
+      track.first.push_back(static_cast<uint32_t>(track.times.size()));
+    }
+    
+    // the node tree and every clip in the layout compileAnimations() produces from Assimp, without names in between;
+    // clips run in seconds
+    void compileGltfAnimations(const cgltf_data* data, const JointMapping& joints, ModelAsset& out) {
+      
+      SkeletonAsset& skel = out.skeleton;
+      skel = SkeletonAsset{};
+      out.clips.clear();
+      
+      //skeleton==================================================
+      std::unordered_map<const cgltf_node*, uint32_t> nodeIds;
+      std::vector<std::pair<const cgltf_node*, uint32_t>> stack;
+      auto roots = getRoots(data);
+      for(auto it = roots.rbegin(); it != roots.rend(); ++it) stack.push_back({*it, SkeletonAsset::NO_PARENT});
+      while(!stack.empty()) {
+        auto [node, parent] = stack.back();
+        stack.pop_back();
+        
+        uint32_t id = static_cast<uint32_t>(skel.parents.size());
+        auto bone = joints.find(node);
+        float local[16];
+        cgltf_node_transform_local(node, local);
+        
+        skel.parents.push_back(parent);
+        skel.bones.push_back(bone != joints.end() ? static_cast<int32_t>(bone->second) : -1);
+        skel.transforms.push_back(glm::make_mat4(local));
+        nodeIds.emplace(node, id);
+        
+        // reversed so the children keep their document order
+        for(cgltf_size i = node->children_count; i-- > 0;) {
+          stack.push_back({node->children[i], id});
+        }
+      }
+      size_t nodeCount = skel.parents.size();
+      //skeleton==================================================
+      
+      //clips==================================================
+      out.clips.reserve(data->animations_count);
+      for(cgltf_size a = 0; a < data->animations_count; ++a) {
+        const cgltf_animation& anim = data->animations[a];
+        AnimClipAsset& clip = out.clips.emplace_back();
+        clip.name = anim.name ? anim.name : fmt::format("anim_{}", a);
+        clip.ticksPerSecond = 1.f;
+        
+        // per node and path, the last channel targeting the same pair wins
+        std::vector<const cgltf_animation_sampler*> translations(nodeCount, nullptr);
+        std::vector<const cgltf_animation_sampler*> rotations(nodeCount, nullptr);
+        std::vector<const cgltf_animation_sampler*> scales(nodeCount, nullptr);
+        for(cgltf_size c = 0; c < anim.channels_count; ++c) {
+          const cgltf_animation_channel& channel = anim.channels[c];
+          auto node = channel.target_node ? nodeIds.find(channel.target_node) : nodeIds.end();
+          if(node == nodeIds.end() || !channel.sampler) continue;
+          
+          const cgltf_animation_sampler* sampler = channel.sampler;
+          bool cubic = sampler->interpolation == cgltf_interpolation_type_cubic_spline;
+          cgltf_type expected = channel.target_path == cgltf_animation_path_type_rotation ? cgltf_type_vec4 : cgltf_type_vec3;
+          if(  sampler->input->type != cgltf_type_scalar
+            || sampler->output->type != expected
+            || sampler->output->count != sampler->input->count * (cubic ? 3 : 1)
+          ) {
+            Logger::warn("glTF: animation {} channel {} has malformed keys, ignored", clip.name, c);
+            continue;
+          }
+          
+          switch(channel.target_path) {
+            case cgltf_animation_path_type_translation: translations[node->second] = sampler; break;
+            case cgltf_animation_path_type_rotation: rotations[node->second] = sampler; break;
+            case cgltf_animation_path_type_scale: scales[node->second] = sampler; break;
+            default: break; // morph weights are not supported
+          }
+        }
+        
+        clip.positions.first.reserve(nodeCount + 1);
+        clip.rotations.first.reserve(nodeCount + 1);
+        clip.scales.first.reserve(nodeCount + 1);
+        for(size_t n = 0; n < nodeCount; ++n) {
+          clip.duration = std::max({
+            clip.duration,
+            appendChannel(clip.positions, translations[n]),
+            appendChannel(clip.rotations, rotations[n]),
+            appendChannel(clip.scales, scales[n])
+          });
+        }
+        closeTrack(clip.positions);
+        closeTrack(clip.rotations);
+        closeTrack(clip.scales);
+      }
+      //clips==================================================
+    }
+  
+  } //namespace
+  
+  //====================================================================================================
+  
+  bool isGltfPath(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::ranges::transform(ext, ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".gltf" || ext == ".glb";
+  }
+  
+  bool importGltf(
+    const std::string& path,
+    ModelAsset& out,
+    ThreadPool* workers,
+    const std::function<void(const ModelAsset&)>& onMaterials
+  ) {
+    
+    // mapped until the primitives are converted
+    GltfFile gltf;
+    if(!openGltf(path, gltf)) return false;
+    const cgltf_data* data = gltf.data.get();
+    auto roots = getRoots(data);
+    
+    // static meshes are baked into model space and the skeleton is evaluated from the scene roots, nothing to undo
+    out.globInverseTransform = glm::mat4(1.f);
+    out.minCoords = glm::vec3(std::numeric_limits<float>::max());
+    out.maxCoords = glm::vec3(std::numeric_limits<float>::lowest());
+    out.hasAnims = data->animations_count > 0;
+    
+    std::vector<GltfPrimitive> prims;
+    bool needsDefaultMaterial = false;
+    for(const auto* root : roots) collectPrimitives(data, root, prims, needsDefaultMaterial);
+    
+    out.materials.resize(data->materials_count + (needsDefaultMaterial ? 1 : 0));
+    // per image, materials may share one
+    std::vector<std::optional<std::string>> extracted(data->images_count);
+    for(cgltf_size i = 0; i < data->materials_count; ++i) {
+      const cgltf_material& mat = data->materials[i];
+      const cgltf_texture* tex = nullptr;
+      if(mat.has_pbr_metallic_roughness) tex = mat.pbr_metallic_roughness.base_color_texture.texture;
+      else if(mat.has_pbr_specular_glossiness) tex = mat.pbr_specular_glossiness.diffuse_texture.texture;
+      if(!tex || !tex->image) continue;
+      
+      const cgltf_image& image = *tex->image;
+      if(image.uri && std::strncmp(image.uri, "data:", 5) != 0) {
+        out.materials[i].diffuse = decodeUri(image.uri);
+        continue;
+      }
+      
+      auto& name = extracted[&image - data->images];
+      if(!name) {
+        name = extractImage(data, image, path);
+        if(name->empty()) Logger::warn("glTF: embedded image {} could not be extracted, material {} is untextured", &image - data->images, mat.name ? mat.name : "");
+      }
+      out.materials[i].diffuse = *name;
+    }
+    
+    if(onMaterials) onMaterials(out);
+    
+    JointMapping joints;
+    if(!collectJoints(data, joints, out.bones)) return false;
+    if(out.hasAnims) compileGltfAnimations(data, joints, out);
+    
+    // primitives convert independently, results are merged back in node order
+    std::vector<std::future<ConvertedMesh>> jobs;
+    if(workers) {
+      jobs.reserve(prims.size());
+      for(const auto& prim : prims) {
+        jobs.push_back(workers->add_task(convertPrimitive, std::cref(prim), std::cref(joints)));
+      }
+    }
+    
+    for(size_t i = 0; i < prims.size(); ++i) {
+      bool queued = i < jobs.size() && jobs[i].valid();
+      addMesh(queued ? jobs[i].get() : convertPrimitive(prims[i], joints), out);
+    }
+    
+    return true;
+  }
+
+}; //V
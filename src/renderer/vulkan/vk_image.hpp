@@ -43,6 +43,15 @@ namespace V {
     return true;
   }
   
+  // full chain down to 1x1
+  static uint32_t getMipLevels(uint32_t w, uint32_t h) {
+    return static_cast<uint32_t>(std::bit_width(std::max(w, h)));
+  }
+  
+  static uint32_t getMipSize(uint32_t size, uint32_t mip) {
+    return std::max(size >> mip, 1u);
+  }
+  
   static bool createImage(
     uint32_t w,
     uint32_t h,
@@ -51,16 +60,17 @@ namespace V {
     vk::ImageUsageFlags usage,
     vk::MemoryPropertyFlags props,
     vk::raii::Image& image,
-    vk::raii::DeviceMemory& imageMem,
-    vk::raii::PhysicalDevice& pDev,
-    vk::raii::Device& lDev
+    VulkanAllocation& imageAlloc,
+    VulkanAllocator& allocator,
+    vk::raii::Device& lDev,
+    uint32_t mipLevels = 1
   ) {
     
     vk::ImageCreateInfo imgInfo{
       .imageType = vk::ImageType::e2D,
       .format = format,
       .extent = vk::Extent3D{w, h, 1},
-      .mipLevels = 1,
+      .mipLevels = mipLevels,
       .arrayLayers = 1,
       .samples = vk::SampleCountFlagBits::e1,
       .tiling = tiling,
@@ -78,38 +88,15 @@ namespace V {
       image = std::move(res.value());
     }
     
-    vk::MemoryRequirements memReq = image.getMemoryRequirements();
-    uint32_t typeIndex = 0;
-    {
-      auto res = findMemType(memReq.memoryTypeBits, props, pDev);
-      if(!res) {
-        Logger::error("Failed to find suitable memory type");
-        return false;
-      }
-      typeIndex = res.value();
-    }
-    vk::MemoryAllocateInfo allocInfo{
-      .allocationSize = memReq.size,
-      .memoryTypeIndex = typeIndex
-    };
-    
-    {
-      auto res = lDev.allocateMemory(allocInfo);
-      if(!res) {
-        Logger::error("Failed to allocate image memory: {}", vk::to_string(res.error()));
-        return false;
-      }
-      imageMem = std::move(res.value());
+    if(!allocator.allocImg(image, props, 0, imageAlloc)) {
+      return false;
     }
-    image.bindMemory(imageMem, 0);
     
     return true;
   }
 
   static bool transitionImageLayout(
-    vk::raii::Device& lDev,
-    vk::raii::CommandPool& cmdPool,
-    vk::raii::Queue& graphQ,
+    vk::raii::CommandBuffer& cmdBuf,
     const vk::Image& image,
     vk::ImageLayout oldLayout,
     vk::ImageLayout newLayout,
@@ -117,16 +104,9 @@ namespace V {
     vk::AccessFlags2 dstAccessMask = {},
     vk::PipelineStageFlags2 srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
     vk::PipelineStageFlags2 dstStageMask = vk::PipelineStageFlagBits2::eBottomOfPipe,
-    vk::raii::CommandBuffer* cmdBuf = nullptr
+    uint32_t baseMip = 0,
+    uint32_t mipCount = 1
   ) {
-    
-    vk::raii::CommandBuffer tempCmdBuf{nullptr};
-    bool useTemp = (cmdBuf == nullptr);
-    
-    if(useTemp) {
-      if(!beginSingleTimeComs(tempCmdBuf, lDev, cmdPool)) return false;
-      cmdBuf = &tempCmdBuf;
-    }
 
     vk::ImageMemoryBarrier2 barrier{
       .srcStageMask = srcStageMask,
@@ -140,8 +120,8 @@ namespace V {
       .image = image,
       .subresourceRange = {
         .aspectMask = vk::ImageAspectFlagBits::eColor,
-        .baseMipLevel = 0,
-        .levelCount = 1,
+        .baseMipLevel = baseMip,
+        .levelCount = mipCount,
         .baseArrayLayer = 0,
         .layerCount = 1
       }
@@ -159,6 +139,33 @@ namespace V {
       barrier.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
       barrier.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
     }
+    else if(oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eTransferSrcOptimal) {
+      // a mip that was just written becomes the source of the next one
+      barrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+      barrier.dstAccessMask = vk::AccessFlagBits2::eTransferRead;
+      barrier.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+      barrier.dstStageMask = vk::PipelineStageFlagBits2::eTransfer;
+    }
+    else if(oldLayout == vk::ImageLayout::eTransferSrcOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
+      barrier.srcAccessMask = vk::AccessFlagBits2::eTransferRead;
+      barrier.dstAccessMask = vk::AccessFlagBits2::eShaderRead;
+      barrier.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+      barrier.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
+    }
+    else if(oldLayout == vk::ImageLayout::eShaderReadOnlyOptimal && newLayout == vk::ImageLayout::eTransferDstOptimal) {
+      // overwritten in place, earlier frames may still sample it
+      barrier.srcAccessMask = {};
+      barrier.dstAccessMask = vk::AccessFlagBits2::eTransferWrite;
+      barrier.srcStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
+      barrier.dstStageMask = vk::PipelineStageFlagBits2::eTransfer;
+    }
+    else if(oldLayout == vk::ImageLayout::eShaderReadOnlyOptimal && newLayout == vk::ImageLayout::eTransferSrcOptimal) {
+      // earlier frames may still sample it
+      barrier.srcAccessMask = {};
+      barrier.dstAccessMask = vk::AccessFlagBits2::eTransferRead;
+      barrier.srcStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
+      barrier.dstStageMask = vk::PipelineStageFlagBits2::eTransfer;
+    }
     else if(oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eColorAttachmentOptimal) {
       barrier.srcAccessMask = srcAccessMask;
       barrier.dstAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite;
@@ -182,49 +189,100 @@ namespace V {
       .pImageMemoryBarriers = &barrier
     };
 
-    cmdBuf->pipelineBarrier2(dependInfo);
-
-    if(useTemp) {
-      if(!endSingleTimeComs(tempCmdBuf, graphQ)) return false;
-    }
+    cmdBuf.pipelineBarrier2(dependInfo);
     
     return true;
   }
 
-  static bool copyBufToImg(
+  static void copyBufToImg(
+    vk::raii::CommandBuffer& cmdBuf,
     const vk::raii::Buffer& buf,
-    vk::raii::Image& img,
+    const vk::raii::Image& img,
     uint32_t w,
     uint32_t h,
-    vk::raii::Device& lDev,
-    vk::raii::CommandPool& cmdPool,
-    vk::raii::Queue& graphQ
+    vk::DeviceSize bufOffset = 0,
+    uint32_t mip = 0
   ) {
-    vk::raii::CommandBuffer cmdBuf{nullptr};
-    if(!beginSingleTimeComs(cmdBuf, lDev, cmdPool)) return false;
-    
     vk::BufferImageCopy region{
-      .bufferOffset = 0,
+      .bufferOffset = bufOffset,
       .bufferRowLength = 0,
       .bufferImageHeight = 0,
-      .imageSubresource = {vk::ImageAspectFlagBits::eColor, 0, 0, 1},
+      .imageSubresource = {vk::ImageAspectFlagBits::eColor, mip, 0, 1},
       .imageOffset = {0, 0, 0},
       .imageExtent = {w, h, 1}
     };
     
     cmdBuf.copyBufferToImage(buf, img, vk::ImageLayout::eTransferDstOptimal, {region});
+  }
+
+  static void blitImg(
+    vk::raii::CommandBuffer& cmdBuf,
+    const vk::Image& src,
+    uint32_t srcW,
+    uint32_t srcH,
+    const vk::Image& dst,
+    uint32_t dstW,
+    uint32_t dstH,
+    uint32_t srcMip = 0,
+    uint32_t dstMip = 0
+  ) {
+    vk::ImageBlit region{
+      .srcSubresource = {vk::ImageAspectFlagBits::eColor, srcMip, 0, 1},
+      .srcOffsets = std::array<vk::Offset3D, 2>{vk::Offset3D{0, 0, 0}, vk::Offset3D{static_cast<int32_t>(srcW), static_cast<int32_t>(srcH), 1}},
+      .dstSubresource = {vk::ImageAspectFlagBits::eColor, dstMip, 0, 1},
+      .dstOffsets = std::array<vk::Offset3D, 2>{vk::Offset3D{0, 0, 0}, vk::Offset3D{static_cast<int32_t>(dstW), static_cast<int32_t>(dstH), 1}}
+    };
     
-    if(!endSingleTimeComs(cmdBuf, graphQ)) return false;
+    cmdBuf.blitImage(src, vk::ImageLayout::eTransferSrcOptimal, dst, vk::ImageLayout::eTransferDstOptimal, {region}, vk::Filter::eLinear);
+  }
+  
+  static void copyImg(
+    vk::raii::CommandBuffer& cmdBuf,
+    const vk::Image& src,
+    const vk::Image& dst,
+    uint32_t w,
+    uint32_t h,
+    uint32_t srcMip = 0,
+    uint32_t dstMip = 0
+  ) {
+    vk::ImageCopy region{
+      .srcSubresource = {vk::ImageAspectFlagBits::eColor, srcMip, 0, 1},
+      .srcOffset = {0, 0, 0},
+      .dstSubresource = {vk::ImageAspectFlagBits::eColor, dstMip, 0, 1},
+      .dstOffset = {0, 0, 0},
+      .extent = {w, h, 1}
+    };
     
-    return true;
+    cmdBuf.copyImage(src, vk::ImageLayout::eTransferSrcOptimal, dst, vk::ImageLayout::eTransferDstOptimal, {region});
   }
-
+  
+  // expects every level in TransferDst with level 0 filled, leaves every level in ShaderReadOnly;
+  // the format must support linear blits
+  static bool generateMips(
+    vk::raii::CommandBuffer& cmdBuf,
+    const vk::Image& img,
+    uint32_t w,
+    uint32_t h,
+    uint32_t mipLevels
+  ) {
+    
+    for(uint32_t i = 1; i < mipLevels; ++i) {
+      if(!transitionImageLayout(cmdBuf, img, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal, {}, {}, {}, {}, i - 1)) return false;
+      blitImg(cmdBuf, img, getMipSize(w, i - 1), getMipSize(h, i - 1), img, getMipSize(w, i), getMipSize(h, i), i - 1, i);
+      if(!transitionImageLayout(cmdBuf, img, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, {}, {}, {}, {}, i - 1)) return false;
+    }
+    
+    return transitionImageLayout(cmdBuf, img, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, {}, {}, {}, {}, mipLevels - 1);
+  }
+  
   static bool createImgView(
     const vk::Image& img,
     vk::Format format,
     vk::ImageAspectFlags aspectFlags,
     vk::raii::ImageView& iv,
-    vk::raii::Device& lDev
+    vk::raii::Device& lDev,
+    uint32_t mipLevels = 1,
+    uint32_t baseMip = 0
   ) {
     
     vk::ImageViewCreateInfo viewInfo{
@@ -233,7 +291,7 @@ namespace V {
       .viewType = vk::ImageViewType::e2D,
       .format = format,
       .components = {},
-      .subresourceRange = { aspectFlags, 0, 1, 0, 1 }
+      .subresourceRange = { aspectFlags, baseMip, mipLevels, 0, 1 }
     };
     
     auto res = lDev.createImageView(viewInfo);
@@ -1,5 +1,4 @@
 #include "vk_material.hpp"
-#include "vk_swapchain.hpp"
 
 namespace V {
   
@@ -7,40 +6,48 @@ namespace V {
   VulkanMaterial::~VulkanMaterial() {}
     
   bool VulkanMaterial::init(
-    const VulkanPplConfig& config,
+    std::shared_ptr<VulkanPipeline> pipeline,
     std::shared_ptr<VulkanTexture> texture,
     vk::raii::Device& lDev,
-    VulkanSwapchain& sc,
-    vk::raii::DescriptorSetLayout& perFrameLayout, // layout set=0
     vk::raii::DescriptorSetLayout& perMaterialLayout, // layout set=1
-    vk::raii::DescriptorPool& descPool,
-    vk::Format depthFormat
+    vk::raii::DescriptorPool& descPool
   ) {
-    m_texture = texture;
-    
-    std::array<vk::DescriptorSetLayout, 2> setLayouts = {perFrameLayout, perMaterialLayout};
-    vk::PipelineLayoutCreateInfo plInfo{
-      .setLayoutCount = setLayouts.size(),
-      .pSetLayouts = setLayouts.data()
-    };
-    
-    if(!m_pipeline.init(lDev, sc, plInfo, depthFormat, config)) {
-      Logger::error("Failed to create pipeline for material");
+    if(!pipeline || !texture) {
+      Logger::error("Material needs a pipeline and a texture");
       return false;
     }
     
+    m_lDev = &lDev;
+    m_perMatLayout = &perMaterialLayout;
+    m_descPool = &descPool;
+    m_pipeline = std::move(pipeline);
+    m_texture = texture;
+    
+    // allocated once, a texture changing its view rewrites them in turn instead of allocating more
+    std::array<vk::DescriptorSetLayout, MATERIAL_DESC_SETS> layouts;
+    layouts.fill(**m_perMatLayout);
     vk::DescriptorSetAllocateInfo allocInfo{
-      .descriptorPool = descPool,
-      .descriptorSetCount = 1,
-      .pSetLayouts = &(*perMaterialLayout)
+      .descriptorPool = *m_descPool,
+      .descriptorSetCount = static_cast<uint32_t>(layouts.size()),
+      .pSetLayouts = layouts.data()
     };
     
-    auto res = lDev.allocateDescriptorSets(allocInfo);
+    auto res = m_lDev->allocateDescriptorSets(allocInfo);
     if(!res) {
-      Logger::error("Failed to allocate material descriptor set: {}", vk::to_string(res.error()));
+      Logger::error("Failed to allocate material descriptor sets: {}", vk::to_string(res.error()));
       return false;
     }
-    m_descSet = std::move(res.value()[0]);
+    m_descSets = std::move(res.value());
+    m_curSet = MATERIAL_DESC_SETS - 1;
+    
+    writeDescSet();
+    return true;
+  }
+  
+  void VulkanMaterial::writeDescSet() {
+    
+    m_curSet = (m_curSet + 1) % MATERIAL_DESC_SETS;
+    m_texVersion = m_texture->getVersion();
     
     vk::DescriptorImageInfo imgInfo{
       .sampler = m_texture->getSampler(),
@@ -49,7 +56,7 @@ namespace V {
     };
     
     vk::WriteDescriptorSet descWrite{
-      .dstSet = *m_descSet,
+      .dstSet = *m_descSets[m_curSet],
       .dstBinding = 0, // binding 0 in set=1
       .dstArrayElement = 0,
       .descriptorCount = 1,
@@ -57,21 +64,25 @@ namespace V {
       .pImageInfo = &imgInfo
     };
     
-    lDev.updateDescriptorSets({descWrite}, {});
-    
-    return true;
+    m_lDev->updateDescriptorSets({descWrite}, {});
   }
   
-  void VulkanMaterial::bind(vk::raii::CommandBuffer& cmdBuf) {
-    cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline.getPipeline());
+  bool VulkanMaterial::bind(vk::raii::CommandBuffer& cmdBuf) {
+    if(m_descSets.empty()) return false;
+    // the retired view stays alive until frames that bound the older sets are done with it
+    if(m_texture->getVersion() != m_texVersion) writeDescSet();
+    
+    cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->getPipeline());
     
     cmdBuf.bindDescriptorSets(
       vk::PipelineBindPoint::eGraphics,
-      m_pipeline.getPipLayout(),
+      m_pipeline->getPipLayout(),
       1, // set=1
-      {*m_descSet},
+      {*m_descSets[m_curSet]},
       {}
     );
+    
+    return true;
   }
   
 }; //V
\ No newline at end of file
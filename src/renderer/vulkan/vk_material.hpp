@@ -7,34 +7,44 @@
 
 namespace V {
   
-  class VulkanSwapchain;
-  
   class VulkanMaterial {
   public:
     
     VulkanMaterial();
     ~VulkanMaterial();
     
+    // the pipeline is shared between every material created from the same config;
+    // both must be set, untextured meshes get the texture cache's fallback
     bool init(
-      const VulkanPplConfig& config,
+      std::shared_ptr<VulkanPipeline> pipeline,
       std::shared_ptr<VulkanTexture> texture,
       vk::raii::Device& lDev,
-      VulkanSwapchain& sc,
-      vk::raii::DescriptorSetLayout& perFrameLayout, // layout set=0
       vk::raii::DescriptorSetLayout& perMaterialLayout, // layout set=1
-      vk::raii::DescriptorPool& descPool,
-      vk::Format depthFormat
+      vk::raii::DescriptorPool& descPool
     );
     
-    void bind(vk::raii::CommandBuffer& cmdBuf);
+    // false if nothing valid can be bound, the draw has to be skipped
+    bool bind(vk::raii::CommandBuffer& cmdBuf);
+    // false while the pipeline compiles in the background or if it failed to
+    bool isReady() const { return m_pipeline->isReady(); }
     
-    vk::raii::PipelineLayout& getPipLayout() { return m_pipeline.getPipLayout(); }
+    vk::raii::PipelineLayout& getPipLayout() { return m_pipeline->getPipLayout(); }
     
   private:
     
+    // points the next set of the ring at the texture's current image view. the set being overwritten was
+    // last bound MATERIAL_DESC_SETS - 1 frames ago, so no frame in flight still uses it
+    void writeDescSet();
+    
+    vk::raii::Device* m_lDev{nullptr};
+    vk::raii::DescriptorSetLayout* m_perMatLayout{nullptr};
+    vk::raii::DescriptorPool* m_descPool{nullptr};
+    
     std::shared_ptr<VulkanTexture> m_texture;
-    VulkanPipeline m_pipeline;
-    vk::raii::DescriptorSet m_descSet{nullptr};
+    uint32_t m_texVersion{0};
+    std::shared_ptr<VulkanPipeline> m_pipeline;
+    std::vector<vk::raii::DescriptorSet> m_descSets;
+    uint32_t m_curSet{0};
     
   };
   
@@ -1,140 +1,46 @@
 #pragma once
 
-#include "vk_buffer.hpp"
-#include "vk_vertex.hpp"
+#include "vk_geometry.hpp"
 
 namespace V {
   
+  // a mesh is only its range inside the geometry pool
   class VulkanMesh {
   public:
     
     VulkanMesh() {}
-    ~VulkanMesh() {}
+    ~VulkanMesh() {
+      if(m_pool && m_handle) {
+        m_pool->free(*m_handle);
+      }
+    }
+    
+    VulkanMesh(const VulkanMesh&) = delete;
+    VulkanMesh& operator=(const VulkanMesh&) = delete;
     
-    bool init(
-      const std::vector<Vertex>& verts,
-      const std::vector<uint32_t>& inds,
-      vk::raii::PhysicalDevice& pDev,
-      vk::raii::Device& lDev,
-      vk::raii::CommandPool& cmdPool,
-      vk::raii::Queue& graphQ
-    ) {
-      if(!createVBuf(
-          verts,
-          pDev,
-          lDev,
-          cmdPool,
-          graphQ
-        )
-        ||
-        !createIBuf(
-          inds,
-          pDev,
-          lDev,
-          cmdPool,
-          graphQ
-        )
-      ) return false;
+    bool init(const GeometryView& geometry, VulkanGeometryPool& pool) {
+      m_handle = pool.alloc(geometry);
+      if(!m_handle) return false;
       
-      m_indCnt = inds.size();
+      m_pool = &pool;
       return true;
     }
     
-    void bind(vk::raii::CommandBuffer& cmdBuf) {
-      cmdBuf.bindVertexBuffers(0, *m_vertBuf, {0});
-      cmdBuf.bindIndexBuffer(*m_indBuf, 0, vk::IndexType::eUint32);
+    // rebinds pool buffers only if the previous draw used a different layout / index type
+    void draw(vk::raii::CommandBuffer& cmdBuf, GeometryBindState& state) {
+      const auto& range = m_pool->get(*m_handle);
+      m_pool->bind(cmdBuf, range, state);
+      cmdBuf.drawIndexed(range.indexCount, 1, range.firstIndex, static_cast<int32_t>(range.vertexOffset), 0);
     }
     
-    uint32_t getIndexCount() { return m_indCnt; }
+    uint32_t getIndexCount() { return m_pool->get(*m_handle).indexCount; }
+    VertexLayout getLayout() { return m_pool->get(*m_handle).layout; }
     
   private:
     
-    bool createVBuf(
-      const std::vector<Vertex>& verts,
-      vk::raii::PhysicalDevice& pDev,
-      vk::raii::Device& lDev,
-      vk::raii::CommandPool& cmdPool,
-      vk::raii::Queue& graphQ
-    ) {
-      
-      vk::DeviceSize bufSize = sizeof(verts[0]) * verts.size();
-      vk::raii::Buffer stagingBuf{nullptr};
-      vk::raii::DeviceMemory stagingBufMem{nullptr};
-      if(!createBuf(
-        bufSize,
-        vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-        stagingBuf,
-        stagingBufMem,
-        pDev,
-        lDev
-      )) return false;
-      
-      void* dataStaging = stagingBufMem.mapMemory(0, bufSize);
-      memcpy(dataStaging, verts.data(), bufSize);
-      stagingBufMem.unmapMemory();
-      
-      if(!createBuf(
-        bufSize,
-        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-        vk::MemoryPropertyFlagBits::eDeviceLocal,
-        m_vertBuf,
-        m_vertBufMem,
-        pDev,
-        lDev
-      )) return false;
-      
-      copyBuffer(stagingBuf, m_vertBuf, bufSize, lDev, cmdPool, graphQ);
-      
-      return true;
-    }
-  
-    bool createIBuf(
-      const std::vector<uint32_t>& inds,
-      vk::raii::PhysicalDevice& pDev,
-      vk::raii::Device& lDev,
-      vk::raii::CommandPool& cmdPool,
-      vk::raii::Queue& graphQ
-    ) {
-      vk::DeviceSize bufSize = sizeof(inds[0]) * inds.size();
-      vk::raii::Buffer stagingBuf{nullptr};
-      vk::raii::DeviceMemory stagingBufMem{nullptr};
-      if(!createBuf(
-        bufSize,
-        vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-        stagingBuf,
-        stagingBufMem,
-        pDev,
-        lDev
-      )) return false;
-      
-      void* data = stagingBufMem.mapMemory(0, bufSize);
-      memcpy(data, inds.data(), bufSize);
-      stagingBufMem.unmapMemory();
-      
-      if(!createBuf(
-        bufSize,
-        vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-        vk::MemoryPropertyFlagBits::eDeviceLocal,
-        m_indBuf,
-        m_indBufMem,
-        pDev,
-        lDev
-      )) return false;
-      
-      copyBuffer(stagingBuf, m_indBuf, bufSize, lDev, cmdPool, graphQ);
-      
-      return true;
-    }
-  
-    
-    vk::raii::Buffer m_vertBuf{nullptr};
-    vk::raii::DeviceMemory m_vertBufMem{nullptr};
-    vk::raii::Buffer m_indBuf{nullptr};
-    vk::raii::DeviceMemory m_indBufMem{nullptr};
-    uint32_t m_indCnt{0};
+    VulkanGeometryPool* m_pool{nullptr};
+    std::optional<GeometryHandle> m_handle;
     
   };
   
-}; //V
\ No newline at end of file
+}; //V
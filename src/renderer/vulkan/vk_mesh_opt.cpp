@@ -0,0 +1,45 @@
+#include "vk_mesh_opt.hpp"
+
+#include <meshoptimizer.h>
+
+namespace V {
+  
+  // typical post-transform cache size of current GPUs, only used for the stats
+  static constexpr unsigned int CACHE_SIZE = 16;
+  // overdraw pass may make vertex cache efficiency at most this much worse
+  static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+  
+  void optimizeMesh(std::vector<Vertex>& verts, std::vector<uint32_t>& inds, std::string_view name) {
+    
+    if(verts.empty() || inds.empty()) return;
+    
+    // lines / points are not worth reordering
+    if(inds.size() % 3 != 0) return;
+    
+    auto before = meshopt_analyzeVertexCache(inds.data(), inds.size(), verts.size(), CACHE_SIZE, 0, 0);
+    size_t vertsBefore = verts.size();
+    
+    // weld: bit-identical vertices (position, normal, uv and skinning) collapse into one
+    std::vector<unsigned int> remap(verts.size());
+    size_t uniqueCnt = meshopt_generateVertexRemap(remap.data(), inds.data(), inds.size(), verts.data(), verts.size(), sizeof(Vertex));
+    
+    std::vector<Vertex> unique(uniqueCnt);
+    meshopt_remapVertexBuffer(unique.data(), verts.data(), verts.size(), sizeof(Vertex), remap.data());
+    meshopt_remapIndexBuffer(inds.data(), inds.data(), inds.size(), remap.data());
+    verts = std::move(unique);
+    
+    meshopt_optimizeVertexCache(inds.data(), inds.data(), inds.size(), verts.size());
+    meshopt_optimizeOverdraw(inds.data(), inds.data(), inds.size(), &verts[0].pos.x, verts.size(), sizeof(Vertex), OVERDRAW_THRESHOLD);
+    meshopt_optimizeVertexFetch(verts.data(), inds.data(), inds.size(), verts.data(), verts.size(), sizeof(Vertex));
+    
+    auto after = meshopt_analyzeVertexCache(inds.data(), inds.size(), verts.size(), CACHE_SIZE, 0, 0);
+    
+    Logger::info("Optimized mesh: {}\t- Vertices: {} -> {}, ACMR: {:.3f} -> {:.3f}, ATVR: {:.3f} -> {:.3f}",
+      name,
+      vertsBefore, verts.size(),
+      before.acmr, after.acmr,
+      before.atvr, after.atvr
+    );
+  }
+  
+}; //V
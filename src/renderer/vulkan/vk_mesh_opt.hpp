@@ -0,0 +1,11 @@
+#pragma once
+
+#include "vk_vertex.hpp"
+
+namespace V {
+  
+  // welds identical vertices, reorders indices for the post-transform cache and overdraw,
+  // then reorders vertices for fetch locality; logs cache stats before and after
+  void optimizeMesh(std::vector<Vertex>& verts, std::vector<uint32_t>& inds, std::string_view name);
+  
+}; //V
@@ -3,9 +3,11 @@
 
 #include <limits>
 #include <filesystem>
+#include <future>
 
 #include "vk_model.hpp"
-#include "../../tools/assimp_glm_helpers.hpp"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
 
 namespace V {
   
@@ -13,10 +15,13 @@ namespace V {
     bool needFlip,
     vk::raii::PhysicalDevice& pDev,
     vk::raii::Device& lDev,
-    VulkanSwapchain& sc,
-    vk::raii::CommandPool& cmdPool,
-    vk::raii::Queue& graphQ,
-    vk::raii::DescriptorSetLayout& perFrameL,
+    VulkanAllocator& allocator,
+    VulkanUploader& uploader,
+    VulkanGeometryPool& geometry,
+    VulkanTextureCache& textures,
+    VulkanPipelineRegistry& pipelines,
+    VulkanDeletionQueue& deletion,
+    ThreadPool& workers,
     vk::raii::DescriptorSetLayout& perMatL,
     vk::raii::DescriptorPool& descPool
   ) {
@@ -25,449 +30,434 @@ namespace V {
     
     m_pDev = &pDev;
     m_lDev = &lDev;
-    m_sc = &sc;
-    m_cmdPool = &cmdPool;
-    m_graphQ = &graphQ;
-    m_perFrameDescSetLayout = &perFrameL;
+    m_allocator = &allocator;
+    m_uploader = &uploader;
+    m_geometry = &geometry;
+    m_textures = &textures;
+    m_pipelines = &pipelines;
+    m_deletion = &deletion;
+    m_workers = &workers;
     m_perMatDescSetLayout = &perMatL;
     m_descPool = &descPool;
     
     m_normMatrix = glm::mat4(1.0f);
     m_baseTransform = glm::mat4(1.0f);
-    m_pImporter = std::make_unique<Assimp::Importer>();
+  }
+  
+  VulkanModel::~VulkanModel() {
+    // the import still writes into m_pending
+    if(m_loadJob.valid()) m_loadJob.wait();
   }
   
   bool VulkanModel::load(const std::string& path) {
-    m_pScene = m_pImporter->ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-
-    if (!m_pScene || m_pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !m_pScene->mRootNode) {
-      Logger::error("ASSIMP: {}", m_pImporter->GetErrorString());
-      m_isLoaded = false;
+    if(m_loadJob.valid()) {
+      Logger::error("Model {} is still loading in the background", m_pending->path);
       return false;
     }
+    
+    m_pending = std::make_unique<PendingLoad>();
+    m_pending->path = path;
+    m_pending->start = std::chrono::steady_clock::now();
     m_dir = path.substr(0, path.find_last_of('/'));
-    m_globInverseTransform = glm::inverse(AssimpToGlmMat4(m_pScene->mRootNode->mTransformation));
     
-    m_minCoords = glm::vec3(std::numeric_limits<float>::max());
-    m_maxCoords = glm::vec3(std::numeric_limits<float>::lowest());
+    // textures decode on the workers while the meshes are converted and uploaded
+    std::vector<std::shared_ptr<VulkanTexture>> textures;
+    auto startTextures = [this, &textures](const ModelAsset& a) { textures = loadTextures(a); };
     
-    m_meshes.clear();
-    m_texLoaded.clear();
-    if(!processNode(m_pScene->mRootNode, m_pScene)) {
+    if(!importAsset(*m_pending, m_workers, startTextures)) {
+      m_pending.reset();
       m_isLoaded = false;
       return false;
     }
     
-    if (m_meshes.empty()) {
-      Logger::error("No meshes found in model: {}", path);
-      m_isLoaded = false;
+    bool res = finishLoad(textures);
+    m_pending.reset();
+    return res;
+  }
+  
+  bool VulkanModel::loadAsync(const std::string& path) {
+    if(m_loadJob.valid()) {
+      Logger::error("Model {} is still loading in the background", m_pending->path);
       return false;
     }
     
-    calculateNormalization();
-    m_isLoaded = true;
+    m_pending = std::make_unique<PendingLoad>();
+    m_pending->path = path;
+    m_pending->start = std::chrono::steady_clock::now();
+    m_progress = 0.f;
+    
+    // the import coordinates from its own thread and fans the meshes out to the workers; on a pool thread
+    // it would wait on tasks queued behind itself when the pool has a single thread.
+    // the texture cache belongs to the render thread, poll() acquires the textures as soon as the materials are known
+    m_loadJob = std::async(std::launch::async, [this, job = m_pending.get()] {
+      return importAsset(*job, m_workers, [job](const ModelAsset&) { job->materialsReady.store(true, std::memory_order_release); });
+    });
+    // the layouts the file uses are not known before the import, compiling both is cheaper than waiting for it
+    prewarmPipelines();
     
-    Logger::info("Model loaded from: {}", path);
+    Logger::info("Loading model {} in the background", path);
     return true;
   }
   
-  void VulkanModel::draw(vk::raii::CommandBuffer& cmdBuf) {
-     for (size_t i = 0; i < m_meshes.size(); ++i) {
-      
-      const auto& mesh = m_meshes[i];
-      uint32_t matIdx = m_meshToMat[i];
-      const auto& material = m_materials[matIdx];
-      
-      material->bind(cmdBuf);
-
-      mesh->bind(cmdBuf);
-
-      cmdBuf.drawIndexed(mesh->getIndexCount(), 1, 0, 0, 0);
+  bool VulkanModel::poll() {
+    if(!m_loadJob.valid()) return true;
+    
+    // the material table is final once flagged, the import only adds meshes after that;
+    // the textures decode on the workers while the meshes convert
+    if(!m_pending->texturesStarted && m_pending->materialsReady.load(std::memory_order_acquire)) {
+      m_dir = m_pending->path.substr(0, m_pending->path.find_last_of('/'));
+      m_pending->textures = loadTextures(m_pending->asset);
+      m_pending->texturesStarted = true;
     }
-  }
-  
-  vk::raii::PipelineLayout& VulkanModel::getPipLayout() {
-    if(m_materials.empty()) {
-      Logger::error("Model has no materials, cannot get pipeline layout");
+    
+    if(m_loadJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return true;
+    
+    bool imported = m_loadJob.get();
+    if(!imported) {
+      Logger::error("Failed to import model {}", m_pending->path);
+      m_pending.reset();
+      return false;
     }
     
-    return m_materials[0]->getPipLayout();
+    if(!m_pending->texturesStarted) {
+      m_dir = m_pending->path.substr(0, m_pending->path.find_last_of('/'));
+      m_pending->textures = loadTextures(m_pending->asset);
+    }
+    bool res = finishLoad(m_pending->textures);
+    m_pending.reset();
+    return res;
   }
   
-  void VulkanModel::setBaseRotation(float angleDegrees, const glm::vec3& axis) {
-    m_baseTransform = glm::rotate(glm::mat4(1.f), glm::radians(angleDegrees), axis);
+  float VulkanModel::getLoadProgress() const {
+    if(isReady()) return 1.f;
+    // the upload is a single batch, nothing finer to report between submit and done
+    if(m_isLoaded) return 0.9f;
+    return m_loadJob.valid() ? m_progress.load() : 0.f;
   }
-
-  bool VulkanModel::processNode(aiNode * node, const aiScene * scene) {
-    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-      aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-      if(!(processMesh(mesh, scene))) {
-        return false;
-      }
-    }
-    for (unsigned int i = 0; i < node->mNumChildren; i++) {
-      if(!processNode(node->mChildren[i], scene)) return false;
-    }
+  
+  bool VulkanModel::importAsset(
+    PendingLoad& job,
+    ThreadPool* workers,
+    const std::function<void(const ModelAsset&)>& onMaterials
+  ) {
     
-    return true;
-  }
-
-  bool VulkanModel::processMesh(aiMesh * mesh, const aiScene * scene) {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-
-    //vertices==================================================
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-      Vertex vertex;
-      vertex.pos = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
-      
-      if (mesh->HasNormals()) {
-        vertex.clr = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
+    // the cook already holds optimized, packed geometry, the skeleton and the clips;
+    // the importers only run when it is missing or stale
+    std::string cookedPath = getCookedPath(job.path);
+    
+    job.cooked = loadCookedModel(cookedPath, job.path, job.asset);
+    m_progress = 0.3f;
+    if(job.cooked) {
+      if(onMaterials) onMaterials(job.asset);
+    } else {
+      job.asset = ModelAsset{};
+      // glTF has its own loader and compiles its clips itself, everything else goes through Assimp
+      // whose importer only lives until the clips are compiled out of its scene
+      if(isGltfPath(job.path)) {
+        if(!importGltf(job.path, job.asset, workers, onMaterials)) return false;
+      } else {
+        Assimp::Importer importer;
+        if(!importModel(importer, job.path, job.asset, workers, onMaterials)) return false;
+        if(job.asset.hasAnims) compileAnimations(*importer.GetScene(), job.asset);
       }
+      m_progress = 0.6f;
       
-      if (mesh->mTextureCoords[0]) {
-        vertex.texCoord = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y};
-      } else {
-        vertex.texCoord = glm::vec2(0.0f, 0.0f);
+      if(!saveCookedModel(cookedPath, job.path, job.asset)) {
+        Logger::warn("Failed to cook {}, it will be imported again next time", job.path);
       }
-      vertices.emplace_back(vertex);
     }
-    //vertices==================================================
     
-    loadBones(mesh, vertices);
+    m_progress = 0.7f;
+    return true;
+  }
+  
+  bool VulkanModel::finishLoad(const std::vector<std::shared_ptr<VulkanTexture>>& textures) {
     
-    //indices==================================================
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-      aiFace face = mesh->mFaces[i];
-      for (unsigned int j = 0; j < face.mNumIndices; j++) {
-        indices.emplace_back(face.mIndices[j]);
-      }
+    const ModelAsset& asset = m_pending->asset;
+    
+    // the previous model's clips stay until here, it may have been animating meanwhile
+    m_skeleton = std::move(m_pending->asset.skeleton);
+    m_clips = std::move(m_pending->asset.clips);
+    m_animTime = 0.f;
+    m_curAnim = 0;
+    
+    m_globInverseTransform = asset.globInverseTransform;
+    m_minCoords = asset.minCoords;
+    m_maxCoords = asset.maxCoords;
+    
+    m_boneOffsets.resize(asset.bones.size());
+    for(size_t i = 0; i < asset.bones.size(); ++i) {
+      m_boneOffsets[i] = asset.bones[i].offset;
     }
-    //indices==================================================
+    m_finalBoneMatrices.assign(asset.bones.size(), glm::mat4(1.f));
+    m_nodeTransforms.resize(m_skeleton.parents.size());
     
-    //materials==================================================
-    uint32_t materialIndex = 0;
-    if (mesh->mMaterialIndex >= 0) {
-      aiMaterial* assimpMaterial = scene->mMaterials[mesh->mMaterialIndex];
-
-      // TODO: materials cache
-
-      auto texture = loadTexture(assimpMaterial, aiTextureType_DIFFUSE);
-      if (!texture) {
-        Logger::warn("Mesh {} has no diffuse texture, skipping material creation for now.", mesh->mName.C_Str());
-      }
-
-      VulkanPplConfig materialConfig{};
-      materialConfig.shaderPath = "../../assets/shaders/shader.spv";
-
-      auto newMaterial = std::make_unique<VulkanMaterial>();
-      vk::Format depthFormat;
-      findDepthFormat(depthFormat, *m_pDev);
-      
-      if (!newMaterial->init(
-        materialConfig, texture,
-        *m_lDev, *m_sc,
-        *m_perFrameDescSetLayout, *m_perMatDescSetLayout,
-        *m_descPool, depthFormat
-      )) {
-        Logger::error("Failed to create material for mesh {}", mesh->mName.C_Str());
+    unload();
+    
+    // before the materials are written, they pick up whatever levels are resident by then
+    for(const auto& tex : textures) {
+      if(!tex || std::ranges::count(m_texLoaded, tex) > 0) continue;
+      // no-op for textures another model already brought in
+      m_texLoaded.push_back(tex);
+      if(!tex->beginStreaming(*m_uploader, *m_lDev, *m_deletion)) {
+        Logger::error("Failed to record the upload of texture {}", tex->s_path);
+        m_isLoaded = false;
         return false;
       }
-
-      m_materials.push_back(std::move(newMaterial));
-      materialIndex = m_materials.size() - 1;
     }
     
-    m_meshToMat.push_back(materialIndex);
-    //materials==================================================
-    
-    for (const auto& vertex : vertices) {
-      m_minCoords = glm::min(m_minCoords, vertex.pos);
-      m_maxCoords = glm::max(m_maxCoords, vertex.pos);
+    if(!createMeshes(asset, textures)) {
+      m_isLoaded = false;
+      return false;
     }
     
-    //mesh==================================================
-    auto vkMesh = std::make_unique<VulkanMesh>();
-    if(!vkMesh->init(vertices, indices, *m_pDev, *m_lDev, *m_cmdPool, *m_graphQ)) {
-      Logger::error("Failed to init vulkan mesh");
+    if (m_meshes.empty()) {
+      Logger::error("No meshes found in model: {}", m_pending->path);
+      m_isLoaded = false;
       return false;
     }
-      m_meshes.emplace_back(std::move(vkMesh));
-    //mesh==================================================
     
-    // if (!textures.empty()) {
-    //   Logger::debug(fmt::format("Mesh '{}' has textures:", mesh->mName.C_Str()));
-    //   for (const auto& tex : textures) {
-    //     Logger::debug(fmt::format("  -> Type: '{}', Path: '{}', ID: {}", tex.s_type, tex.s_path, tex.s_id));
-    //   }
-    // } else {
-    //   Logger::warn(fmt::format("Mesh '{}' has material, but NO textures were loaded for it.", mesh->mName.C_Str()));
-    // }
+    calculateNormalization();
     
-    Logger::info("Processed mesh: {}\t- Vertices: {}, Indices: {}"/*, Textures: {}"*/, mesh->mName.C_Str(), vertices.size(), indices.size()/*, m_texLoaded.size()*/);
+    // every mesh and texture of the model goes to the GPU in one batch
+    m_uploadTicket = m_uploader->flush();
+    m_isLoaded = true;
     
+    auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_pending->start).count();
+    Logger::info("Model loaded from: {} ({}, {:.1f} ms)", m_pending->path, m_pending->cooked ? "cooked" : "imported", ms);
     return true;
   }
-
-  std::shared_ptr<VulkanTexture> VulkanModel::loadTexture(aiMaterial* mat, aiTextureType type) {
-    
-    if(mat->GetTextureCount(type) > 0) {
-      aiString str;
-      mat->GetTexture(type, 0, &str);
-      bool skip = false;
-      for(uint32_t j = 0; j < m_texLoaded.size(); ++j) {
-        if(std::strcmp(m_texLoaded[j]->s_path.data(), str.C_Str()) == 0) {
-          m_texLoaded.emplace_back(m_texLoaded[j]);
-          skip = true;
-          break;
-        }
-      }
-      
-      if(!skip) {
-        std::filesystem::path texturePath(str.C_Str());
-        std::string fName = texturePath.filename().string();
-        std::filesystem::path finalPath = std::filesystem::path(m_dir) / ".." / "textures" / fName;
-        if (!std::filesystem::exists(finalPath)) {
-          Logger::warn("Texture not found at default path: {}. Trying alongside fbx...", finalPath.string());
-          finalPath = std::filesystem::path(m_dir) / fName;
-        }
-        std::string path = finalPath.string();
-
-        Logger::info("Attempting to load texture from: {}", path.data());
-        auto newTex = std::make_shared<VulkanTexture>();
-        if(newTex->init(path, *m_pDev, *m_lDev, *m_cmdPool, *m_graphQ)) {
-          return newTex;
-        }
-      }
-    }
-    
-    Logger::error("Failed to create vulkan texture");
-    return nullptr;
-  }
   
-  void VulkanModel::calculateNormalization() {
-    glm::vec3 center = (m_minCoords + m_maxCoords) * 0.5f;
-    glm::vec3 size = m_maxCoords - m_minCoords;
-    float maxDim = glm::max(glm::max(size.x, size.y), size.z);
-
-    if (maxDim == 0.0f) {
-      m_normMatrix = glm::mat4(1.0f);
-      return;
-    }
-
-    float scaleFactor = 2.0f / maxDim;
-    glm::mat4 translate = glm::translate(glm::mat4(1.0f), -center);
-    glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(scaleFactor));
-    m_normMatrix = scale * translate;
-
-    Logger::info("Model normalized: center({}, {}, {}), scale_factor: {}", center.x, center.y, center.z, scaleFactor);
+  void VulkanModel::unload() {
+    if(m_meshes.empty()) return;
+    
+    // meshes hand their ranges to the deletion queue themselves
+    m_meshes.clear();
+    m_meshToMat.clear();
+    m_deletion->push(std::move(m_materials), std::move(m_texLoaded));
+    m_materials.clear();
+    m_texLoaded.clear();
+    m_isLoaded = false;
+    
+    // give the holes back as one block once the ranges are actually free,
+    // so the next model does not have to grow the pool
+    m_deletion->defer([geometry = m_geometry]() { geometry->compact(); });
   }
   
-  void VulkanModel::updAnim(float dT) {
-    if(m_pScene && m_pScene->HasAnimations()) {
-      float ticksPerSec = m_pScene->mAnimations[m_curAnim]->mTicksPerSecond != 0 ? m_pScene->mAnimations[m_curAnim]->mTicksPerSecond : 25.f;
-      float timeInTicks = dT * ticksPerSec;
-      float animDur = m_pScene->mAnimations[m_curAnim]->mDuration;
-      
-      m_animTime = fmod(m_animTime + timeInTicks, animDur);
+  void VulkanModel::draw(vk::raii::CommandBuffer& cmdBuf, GeometryBindState& geomState) {
+    std::optional<uint32_t> boundMat;
+    for (size_t i = 0; i < m_meshes.size(); ++i) {
       
-      readNodeHierarchy(m_animTime, m_pScene->mRootNode, glm::mat4(1.f));
+      const auto& mesh = m_meshes[i];
+      uint32_t matIdx = m_meshToMat[i];
       
-      m_finalBoneMatrices.resize(m_numBones);
-      for(uint32_t i = 0; i < m_numBones; ++i) {
-        m_finalBoneMatrices[i] = m_boneInfo[i].finalTransform;
+      // meshes sharing a material only rebind when something else was bound in between
+      if(boundMat != matIdx) {
+        // the mesh shows up once its pipeline is compiled
+        if(!m_materials[matIdx]->isReady() || !m_materials[matIdx]->bind(cmdBuf)) continue;
+        boundMat = matIdx;
       }
+      
+      mesh->draw(cmdBuf, geomState);
     }
   }
   
-  void VulkanModel::setAnim(uint32_t animIndex) {
-    if(m_pScene && animIndex < m_pScene->mNumAnimations) {
-      m_curAnim = animIndex;
-      m_animTime = 0.f;
-    }
+  void VulkanModel::setBaseRotation(float angleDegrees, const glm::vec3& axis) {
+    m_baseTransform = glm::rotate(glm::mat4(1.f), glm::radians(angleDegrees), axis);
   }
-  
-  void VulkanModel::loadBones(const aiMesh* pMesh, std::vector<Vertex>& vertices) {
-    for(uint32_t i = 0; i < pMesh->mNumBones; ++i) {
-      uint32_t boneIndex = 0;
-      std::string boneName(pMesh->mBones[i]->mName.data);
+
+  bool VulkanModel::createMeshes(const ModelAsset& asset, const std::vector<std::shared_ptr<VulkanTexture>>& textures) {
+    
+    // (asset material, pipeline, texture) -> index into m_materials; the pipeline stands in for its config
+    std::map<std::tuple<uint32_t, const VulkanPipeline*, const VulkanTexture*>, uint32_t> matByKey;
+    std::set<const VulkanPipeline*> pipelines;
+    
+    for(const auto& mesh : asset.meshes) {
       
-      if(m_boneMapping.find(boneName) == m_boneMapping.end()) {
-        boneIndex = m_numBones;
-        m_numBones++;
-        
-        // Logger::debug("New bone found: '{}', assigning index {}. Resizing m_boneInfo to {}.", boneName, boneIndex, m_numBones);
-        if (m_numBones > MAX_BONES) {
-          Logger::error("FATAL: Number of bones ({}) exceeds MAX_BONES ({}). Increase MAX_BONES in opengl_model.hpp and animated.vert shader.",
-                                    m_numBones, MAX_BONES);
-          return; 
-        }
-        
-        m_boneInfo.resize(m_numBones);
-        m_boneInfo[boneIndex].boneOffset = AssimpToGlmMat4(pMesh->mBones[i]->mOffsetMatrix);
-        m_boneMapping[boneName] = boneIndex;
-      } else {
-        boneIndex = m_boneMapping[boneName];
+      // nothing to draw, e.g. a node whose primitives were all skipped
+      if(mesh.geometry.vertexCount == 0 || mesh.geometry.indexCount == 0) {
+        Logger::warn("Mesh {} is empty, skipped", mesh.name);
+        continue;
       }
       
-      for(uint32_t j = 0; j < pMesh->mBones[i]->mNumWeights; ++j) {
-        uint32_t vertexID = pMesh->mBones[i]->mWeights[j].mVertexId;
-        float weight = pMesh->mBones[i]->mWeights[j].mWeight;
-        
-        for(int k = 0; k < MAX_BONES_PER_VERTEX; ++k) {
-          if(vertices[vertexID].weights[k] == 0.f) {
-            vertices[vertexID].boneIDs[k] = boneIndex;
-            vertices[vertexID].weights[k] = weight;
-            break;
-          }
-        }
+      //materials==================================================
+      // untextured materials, and textures that failed to load, sample a white texel
+      auto texture = textures[mesh.material] ? textures[mesh.material] : m_textures->getFallback();
+      if(!texture) {
+        Logger::error("Failed to create material for mesh {}", mesh.name);
+        return false;
       }
-    }
-    
-    // normalize weights
-    for(size_t i = 0; i < vertices.size(); ++i) {
-      float totalWeight = 0.0f;
-      for(int j = 0; j < MAX_BONES_PER_VERTEX; ++j) {
-        totalWeight += vertices[i].weights[j];
+      
+      // shared with every model using the same config
+      auto pipeline = m_pipelines->acquire(getMaterialConfig(mesh.geometry.layout));
+      if(!pipeline) {
+        Logger::error("Failed to create material for mesh {}", mesh.name);
+        return false;
       }
       
-      if (totalWeight > 0.0f) {
-        for(int j = 0; j < MAX_BONES_PER_VERTEX; ++j) {
-          vertices[i].weights[j] /= totalWeight;
+      auto key = std::make_tuple(mesh.material, pipeline.get(), texture.get());
+      auto it = matByKey.find(key);
+      if(it == matByKey.end()) {
+        auto newMaterial = std::make_unique<VulkanMaterial>();
+        if (!newMaterial->init(
+          pipeline, texture,
+          *m_lDev, *m_perMatDescSetLayout,
+          *m_descPool
+        )) {
+          Logger::error("Failed to create material for mesh {}", mesh.name);
+          return false;
         }
+        
+        m_materials.push_back(std::move(newMaterial));
+        pipelines.insert(pipeline.get());
+        it = matByKey.emplace(key, static_cast<uint32_t>(m_materials.size() - 1)).first;
       }
-    }
-  }
-  
-  void VulkanModel::readNodeHierarchy(float animTime, const aiNode* pNode, const glm::mat4& parentTransform) {
-    std::string nodeName(pNode->mName.data);
-    const aiAnimation* pAnim = m_pScene->mAnimations[m_curAnim];
-    glm::mat4 nodeTransform = AssimpToGlmMat4(pNode->mTransformation);
-    
-    const aiNodeAnim* pNodeAnim = findNodeAnim(pAnim, nodeName);
-    
-    if(pNodeAnim) {
-      glm::vec3 scaling;
-      calcInterpolatedScaling(scaling, animTime, pNodeAnim);
-      glm::mat4 scalingM = glm::scale(glm::mat4(1.f), scaling);
-      
-      glm::quat rotatQ;
-      calcInterpolatedRotation(rotatQ, animTime, pNodeAnim);
-      glm::mat4 rotationM = glm::toMat4(rotatQ);
+      m_meshToMat.push_back(it->second);
+      //materials==================================================
       
-      glm::vec3 posit;
-      calcInterpolatedPosition(posit, animTime, pNodeAnim);
-      glm::mat4 positionM = glm::translate(glm::mat4(1.f), posit);
+      //mesh==================================================
+      auto vkMesh = std::make_unique<VulkanMesh>();
+      if(!vkMesh->init(mesh.geometry, *m_geometry)) {
+        Logger::error("Failed to init vulkan mesh");
+        return false;
+      }
+      m_meshes.emplace_back(std::move(vkMesh));
+      //mesh==================================================
       
-      nodeTransform = positionM * rotationM * scalingM;
+      Logger::info("Processed mesh: {}\t- Vertices: {}, Indices: {}", mesh.name, mesh.geometry.vertexCount, mesh.geometry.indexCount);
     }
     
-    glm::mat4 globTransform = parentTransform * nodeTransform;
+    // every pipeline the model was missing compiles in one batch
+    m_pipelines->flush();
     
-    if(m_boneMapping.find(nodeName) != m_boneMapping.end()) {
-      uint32_t boneInd = m_boneMapping[nodeName];
-      m_boneInfo[boneInd].finalTransform = m_globInverseTransform * globTransform * m_boneInfo[boneInd].boneOffset;
-    }
-    
-    for(uint32_t i = 0; i < pNode->mNumChildren; ++i) {
-      readNodeHierarchy(animTime, pNode->mChildren[i], globTransform);
-    }
+    Logger::info("{} meshes share {} materials and {} pipelines", m_meshes.size(), m_materials.size(), pipelines.size());
+    return true;
   }
   
-  const aiNodeAnim* VulkanModel::findNodeAnim(const aiAnimation* pAnim, const std::string& nodeName) {
-    for(uint32_t i = 0; i < pAnim->mNumChannels; ++i) {
-      const aiNodeAnim* pNodeAnim = pAnim->mChannels[i];
-      if(std::string(pNodeAnim->mNodeName.data) == nodeName) {
-        return pNodeAnim;
-      }
-    }
-    
-    return nullptr;
+  VulkanPplConfig VulkanModel::getMaterialConfig(VertexLayout layout) {
+    VulkanPplConfig config{};
+    config.shaderPath = "../../assets/shaders/shader.spv";
+    config.vertexLayout = layout;
+    return config;
+  }
+  
+  void VulkanModel::prewarmPipelines() {
+    std::array<VulkanPplConfig, VERTEX_LAYOUT_COUNT> configs;
+    for(uint32_t i = 0; i < VERTEX_LAYOUT_COUNT; ++i) configs[i] = getMaterialConfig(static_cast<VertexLayout>(i));
+    m_pipelines->prewarm(configs);
   }
   
-  uint32_t VulkanModel::findScaling(float animTime, const aiNodeAnim* pNodeAnim) {
-    for (unsigned int i = 0; i < pNodeAnim->mNumScalingKeys - 1; i++) {
-      if (animTime < static_cast<float>(pNodeAnim->mScalingKeys[i + 1].mTime)) {
-        return i;
+  std::vector<std::shared_ptr<VulkanTexture>> VulkanModel::loadTextures(const ModelAsset& asset) {
+    
+    std::vector<std::shared_ptr<VulkanTexture>> res(asset.materials.size());
+    for(size_t i = 0; i < asset.materials.size(); ++i) {
+      if(!asset.materials[i].diffuse.empty()) {
+        res[i] = loadTexture(asset.materials[i].diffuse);
       }
     }
-    return 0;
+    
+    return res;
   }
   
-  void VulkanModel::calcInterpolatedScaling(glm::vec3& out, float animTime, const aiNodeAnim* pNodeAnim) {
-    if (pNodeAnim->mNumScalingKeys == 1) {
-      out = {pNodeAnim->mScalingKeys[0].mValue.x, pNodeAnim->mScalingKeys[0].mValue.y, pNodeAnim->mScalingKeys[0].mValue.z};
-      return;
+  std::shared_ptr<VulkanTexture> VulkanModel::loadTexture(const std::string& name) {
+    
+    std::filesystem::path texturePath(name);
+    std::string fName = texturePath.filename().string();
+    std::filesystem::path finalPath = std::filesystem::path(m_dir) / ".." / "textures" / fName;
+    if (!std::filesystem::exists(finalPath)) {
+      Logger::warn("Texture not found at default path: {}. Trying alongside fbx...", finalPath.string());
+      finalPath = std::filesystem::path(m_dir) / fName;
     }
-
-    unsigned int scalingIndex = findScaling(animTime, pNodeAnim);
-    unsigned int nextScalingIndex = scalingIndex + 1;
-    float deltaTime = (float)(pNodeAnim->mScalingKeys[nextScalingIndex].mTime - pNodeAnim->mScalingKeys[scalingIndex].mTime);
-    float factor = (animTime - (float)pNodeAnim->mScalingKeys[scalingIndex].mTime) / deltaTime;
-    
-    const aiVector3D& start = pNodeAnim->mScalingKeys[scalingIndex].mValue;
-    const aiVector3D& end = pNodeAnim->mScalingKeys[nextScalingIndex].mValue;
-    aiVector3D delta = end - start;
-    aiVector3D final = start + factor * delta;
-
-    out = {final.x, final.y, final.z};
+    std::string path = finalPath.string();
+    
+    auto tex = m_textures->acquire(path);
+    if(!tex) {
+      Logger::error("Failed to create vulkan texture");
+    }
+    
+    return tex;
   }
   
-  uint32_t VulkanModel::findRotation(float animTime, const aiNodeAnim* pNodeAnim) {
-    for (unsigned int i = 0; i < pNodeAnim->mNumRotationKeys - 1; i++) {
-      if (animTime < static_cast<float>(pNodeAnim->mRotationKeys[i + 1].mTime)) {
-        return i;
+  void VulkanModel::requestTextureSizes(const glm::mat4& mvp, vk::Extent2D extent) {
+    
+    glm::vec2 lo{1.f}, hi{-1.f};
+    for(uint32_t i = 0; i < 8; ++i) {
+      glm::vec4 corner = mvp * glm::vec4(
+        i & 1 ? m_maxCoords.x : m_minCoords.x,
+        i & 2 ? m_maxCoords.y : m_minCoords.y,
+        i & 4 ? m_maxCoords.z : m_minCoords.z,
+        1.f
+      );
+      if(corner.w <= 0.f) {
+        // crosses the camera plane, treat it as filling the screen
+        lo = glm::vec2{-1.f};
+        hi = glm::vec2{1.f};
+        break;
       }
+      glm::vec2 ndc = glm::vec2(corner) / corner.w;
+      lo = glm::min(lo, ndc);
+      hi = glm::max(hi, ndc);
     }
-    return 0;
+    lo = glm::clamp(lo, -1.f, 1.f);
+    hi = glm::clamp(hi, -1.f, 1.f);
+    
+    glm::vec2 px = glm::max(hi - lo, 0.f) * 0.5f * glm::vec2(extent.width, extent.height);
+    uint32_t size = static_cast<uint32_t>(std::ceil(glm::max(px.x, px.y)));
+    for(const auto& tex : m_texLoaded) tex->requestSize(size);
   }
   
-  void VulkanModel::calcInterpolatedRotation(glm::quat& out, float animTime, const aiNodeAnim* pNodeAnim) {
-    if (pNodeAnim->mNumRotationKeys == 1) {
-      const auto& val = pNodeAnim->mRotationKeys[0].mValue;
-      out = glm::quat(val.w, val.x, val.y, val.z);
+  void VulkanModel::calculateNormalization() {
+    glm::vec3 center = (m_minCoords + m_maxCoords) * 0.5f;
+    glm::vec3 size = m_maxCoords - m_minCoords;
+    float maxDim = glm::max(glm::max(size.x, size.y), size.z);
+
+    if (maxDim == 0.0f) {
+      m_normMatrix = glm::mat4(1.0f);
       return;
     }
 
-    unsigned int rotationIndex = findRotation(animTime, pNodeAnim);
-    unsigned int nextRotationIndex = rotationIndex + 1;
-    float deltaTime = (float)(pNodeAnim->mRotationKeys[nextRotationIndex].mTime - pNodeAnim->mRotationKeys[rotationIndex].mTime);
-    float factor = (animTime - (float)pNodeAnim->mRotationKeys[rotationIndex].mTime) / deltaTime;
-
-    const aiQuaternion& start = pNodeAnim->mRotationKeys[rotationIndex].mValue;
-    const aiQuaternion& end = pNodeAnim->mRotationKeys[nextRotationIndex].mValue;
-    aiQuaternion final;
-    aiQuaternion::Interpolate(final, start, end, factor);
+    float scaleFactor = 2.0f / maxDim;
+    glm::mat4 translate = glm::translate(glm::mat4(1.0f), -center);
+    glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(scaleFactor));
+    m_normMatrix = scale * translate;
 
-    out = glm::quat(final.w, final.x, final.y, final.z);
+    Logger::info("Model normalized: center({}, {}, {}), scale_factor: {}", center.x, center.y, center.z, scaleFactor);
   }
   
-  uint32_t VulkanModel::findPosition(float animTime, const aiNodeAnim* pNodeAnim) {
-    for (unsigned int i = 0; i < pNodeAnim->mNumPositionKeys - 1; i++) {
-      if (animTime < static_cast<float>(pNodeAnim->mPositionKeys[i + 1].mTime)) {
-        return i;
+  void VulkanModel::updAnim(float dT) {
+    if(!hasAnims()) return;
+    
+    const AnimClipAsset& clip = m_clips[m_curAnim];
+    if(clip.duration > 0.f) {
+      m_animTime = fmod(m_animTime + dT * clip.ticksPerSecond, clip.duration);
+    }
+    
+    // parents come first, their global transform is always ready
+    for(uint32_t node = 0; node < m_skeleton.parents.size(); ++node) {
+      glm::mat4 nodeTransform = m_skeleton.transforms[node];
+      
+      if(clip.positions.has(node) || clip.rotations.has(node) || clip.scales.has(node)) {
+        glm::mat4 positionM = glm::translate(glm::mat4(1.f), clip.positions.sample(node, m_animTime, glm::vec3(0.f)));
+        glm::mat4 rotationM = glm::toMat4(clip.rotations.sample(node, m_animTime, glm::quat(1.f, 0.f, 0.f, 0.f)));
+        glm::mat4 scalingM = glm::scale(glm::mat4(1.f), clip.scales.sample(node, m_animTime, glm::vec3(1.f)));
+        nodeTransform = positionM * rotationM * scalingM;
+      }
+      
+      uint32_t parent = m_skeleton.parents[node];
+      m_nodeTransforms[node] = parent == SkeletonAsset::NO_PARENT ? nodeTransform : m_nodeTransforms[parent] * nodeTransform;
+      
+      int32_t bone = m_skeleton.bones[node];
+      if(bone >= 0) {
+        m_finalBoneMatrices[bone] = m_globInverseTransform * m_nodeTransforms[node] * m_boneOffsets[bone];
       }
     }
-    return 0;
   }
   
-  void VulkanModel::calcInterpolatedPosition(glm::vec3& out, float animTime, const aiNodeAnim* pNodeAnim) {
-    if (pNodeAnim->mNumPositionKeys == 1) {
-      out = {pNodeAnim->mPositionKeys[0].mValue.x, pNodeAnim->mPositionKeys[0].mValue.y, pNodeAnim->mPositionKeys[0].mValue.z};
-      return;
+  void VulkanModel::setAnim(uint32_t animIndex) {
+    if(animIndex < m_clips.size()) {
+      m_curAnim = animIndex;
+      m_animTime = 0.f;
     }
-    
-    unsigned int positionIndex = findPosition(animTime, pNodeAnim);
-    unsigned int nextPositionIndex = positionIndex + 1;
-    float deltaTime = (float)(pNodeAnim->mPositionKeys[nextPositionIndex].mTime - pNodeAnim->mPositionKeys[positionIndex].mTime);
-    float factor = (animTime - (float)pNodeAnim->mPositionKeys[positionIndex].mTime) / deltaTime;
-
-    const aiVector3D& start = pNodeAnim->mPositionKeys[positionIndex].mValue;
-    const aiVector3D& end = pNodeAnim->mPositionKeys[nextPositionIndex].mValue;
-    aiVector3D delta = end - start;
-    aiVector3D final = start + factor * delta;
-    
-    out = {final.x, final.y, final.z};
   }
   
 }; //V
\ No newline at end of file
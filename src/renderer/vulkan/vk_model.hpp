@@ -3,26 +3,18 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
 #include "vk_mesh.hpp"
+#include "vk_model_asset.hpp"
 #include "vk_texture.hpp"
 #include "vk_material.hpp"
+#include "vk_texture_cache.hpp"
+#include "vk_pipeline_registry.hpp"
 
 #include <map>
 
 
 namespace V {
   
-  class VulkanSwapchain;
-  
-  struct BoneInfo {
-    glm::mat4 boneOffset;
-    glm::mat4 finalTransform;
-  };
-  
   class VulkanModel {
   public:
   
@@ -30,58 +22,99 @@ namespace V {
       bool needFlip,
       vk::raii::PhysicalDevice& pDev,
       vk::raii::Device& lDev,
-      VulkanSwapchain& sc,
-      vk::raii::CommandPool& cmdPool,
-      vk::raii::Queue& graphQ,
-      vk::raii::DescriptorSetLayout& perFrameL,
+      VulkanAllocator& allocator,
+      VulkanUploader& uploader,
+      VulkanGeometryPool& geometry,
+      VulkanTextureCache& textures,
+      VulkanPipelineRegistry& pipelines,
+      VulkanDeletionQueue& deletion,
+      ThreadPool& workers,
       vk::raii::DescriptorSetLayout& perMatL,
       vk::raii::DescriptorPool& descPool
     );
     
+    ~VulkanModel();
+    
+    // blocks until the model is built and its upload is submitted
     bool load(const std::string& path);
+    // imports on a background thread and returns right away; poll() builds the GPU side once the import is done.
+    // the previous model, if any, keeps drawing until then
+    bool loadAsync(const std::string& path);
+    // once per frame on the render thread, false if a background load failed
+    bool poll();
+    bool isLoading() const { return m_loadJob.valid(); }
+    // 0..1, reaches 1 when isReady()
+    float getLoadProgress() const;
+    // GPU resources go to the deletion queue, frames in flight keep drawing the old model
+    void unload();
     
-    void draw(vk::raii::CommandBuffer& cmdBuf);
+    void draw(vk::raii::CommandBuffer& cmdBuf, GeometryBindState& geomState);
     
-    vk::raii::PipelineLayout& getPipLayout();
     bool isLoaded() const { return m_isLoaded; };
+    bool isReady() const { return m_isLoaded && m_uploader->isDone(m_uploadTicket); }
+    UploadTicket getUploadTicket() const { return m_uploadTicket; }
+    // projected bounding box in pixels as the wanted texture size, VulkanTextureCache::stream() picks it up
+    void requestTextureSizes(const glm::mat4& mvp, vk::Extent2D extent);
     
     const glm::mat4& getNormMatrix() const { return m_normMatrix; };
     const std::vector<glm::mat4> getBoneTransforms() { return m_finalBoneMatrices; };
     void setBaseRotation(float angleDegrees, const glm::vec3& axis);
     
-    bool hasAnims() const { return m_pScene && m_pScene->HasAnimations(); }
+    bool hasAnims() const { return !m_clips.empty(); }
     void updAnim(float dT);
     void setAnim(uint32_t animIndex);
      
     bool flipVertically = true;
     
   private:
-    bool processNode(aiNode * node, const aiScene * scene);
-    bool processMesh(aiMesh * mesh, const aiScene * scene);
     
-    std::shared_ptr<VulkanTexture> loadTexture(aiMaterial* mat, aiTextureType type);
+    // CPU side of a load, owned by the model while the import runs
+    struct PendingLoad {
+      std::string path;
+      ModelAsset asset;
+      // set by the import once asset.materials is filled, before the meshes convert
+      std::atomic<bool> materialsReady{false};
+      // render thread only
+      bool texturesStarted{false};
+      std::vector<std::shared_ptr<VulkanTexture>> textures;
+      bool cooked{false};
+      std::chrono::steady_clock::time_point start;
+    };
     
-    void calculateNormalization();
+    // cooked file, glTF or Assimp import, safe off the render thread: touches only `job` and m_progress.
+    // waits on `workers`, so it must not run on one of them
+    bool importAsset(
+      PendingLoad& job,
+      ThreadPool* workers,
+      const std::function<void(const ModelAsset&)>& onMaterials
+    );
+    // render thread: swaps the scene in, replaces the meshes and flushes their upload
+    bool finishLoad(const std::vector<std::shared_ptr<VulkanTexture>>& textures);
+    
+    // what a material of the given vertex layout is drawn with
+    static VulkanPplConfig getMaterialConfig(VertexLayout layout);
+    // every config getMaterialConfig() can return, compiled on the workers while the import runs
+    void prewarmPipelines();
     
-    void loadBones(const aiMesh* pMesh, std::vector<Vertex>& vertices);
-    const aiNodeAnim* findNodeAnim(const aiAnimation* pAnim, const std::string& nodeName);
-    void readNodeHierarchy(float animTime, const aiNode* pNode, const glm::mat4& parentTransform);
+    bool createMeshes(const ModelAsset& asset, const std::vector<std::shared_ptr<VulkanTexture>>& textures);
     
-    uint32_t findScaling(float animTime, const aiNodeAnim* pNodeAnim);
-    uint32_t findRotation(float animTime, const aiNodeAnim* pNodeAnim);
-    uint32_t findPosition(float animTime, const aiNodeAnim* pNodeAnim);
-    void calcInterpolatedScaling(glm::vec3& out, float animTime, const aiNodeAnim* pNodeAnim);
-    void calcInterpolatedRotation(glm::quat& out, float animTime, const aiNodeAnim* pNodeAnim);
-    void calcInterpolatedPosition(glm::vec3& out, float animTime, const aiNodeAnim* pNodeAnim);
+    // one texture per asset material (nullptr without a diffuse map), new ones decode in the background
+    std::vector<std::shared_ptr<VulkanTexture>> loadTextures(const ModelAsset& asset);
+    std::shared_ptr<VulkanTexture> loadTexture(const std::string& name);
+    
+    void calculateNormalization();
     
     //====================================================================================================
     
     vk::raii::PhysicalDevice* m_pDev{nullptr};
     vk::raii::Device* m_lDev{nullptr};
-    VulkanSwapchain* m_sc{nullptr};
-    vk::raii::CommandPool* m_cmdPool{nullptr};
-    vk::raii::Queue* m_graphQ{nullptr};
-    vk::raii::DescriptorSetLayout* m_perFrameDescSetLayout;
+    VulkanAllocator* m_allocator{nullptr};
+    VulkanUploader* m_uploader{nullptr};
+    VulkanGeometryPool* m_geometry{nullptr};
+    VulkanTextureCache* m_textures{nullptr};
+    VulkanPipelineRegistry* m_pipelines{nullptr};
+    VulkanDeletionQueue* m_deletion{nullptr};
+    ThreadPool* m_workers{nullptr};
     vk::raii::DescriptorSetLayout* m_perMatDescSetLayout;
     vk::raii::DescriptorPool* m_descPool;
     
@@ -95,13 +128,16 @@ namespace V {
     glm::vec3 m_minCoords;
     glm::vec3 m_maxCoords;
     bool m_isLoaded = false;
+    UploadTicket m_uploadTicket{0};
+    std::unique_ptr<PendingLoad> m_pending;
+    std::future<bool> m_loadJob;
+    std::atomic<float> m_progress{0.f};
     
     // anim
-    std::unique_ptr<Assimp::Importer> m_pImporter;
-    const aiScene* m_pScene = nullptr;
-    std::map<std::string, uint32_t> m_boneMapping;
-    uint32_t m_numBones{0};
-    std::vector<BoneInfo> m_boneInfo;
+    SkeletonAsset m_skeleton;
+    std::vector<AnimClipAsset> m_clips;
+    std::vector<glm::mat4> m_boneOffsets;
+    std::vector<glm::mat4> m_nodeTransforms; // model space, rebuilt by updAnim()
     std::vector<glm::mat4> m_finalBoneMatrices;
     glm::mat4 m_globInverseTransform;
     float m_animTime = 0.f;
@@ -0,0 +1,751 @@
+#include <filesystem>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "vk_model_asset.hpp"
+#include "vk_mesh_opt.hpp"
+#include "../../tools/assimp_glm_helpers.hpp"
+
+namespace V {
+  
+  namespace {
+    
+    // on-disk layout, native endianness: header, mesh / material / bone / node / clip tables, 16-byte aligned blobs, string pool
+    constexpr std::array<char, 4> COOKED_MAGIC = {'V', 'M', 'D', 'L'};
+    constexpr uint32_t COOKED_VERSION = 3;
+    constexpr uint64_t COOKED_ALIGN = 16;
+    constexpr uint32_t COOKED_HAS_ANIMS = 1 << 0;
+    
+    struct CookedString {
+      uint32_t offset;
+      uint32_t length;
+    };
+    
+    struct CookedHeader {
+      std::array<char, 4> magic;
+      uint32_t version;
+      uint64_t sourceSize;
+      int64_t sourceTime;
+      uint32_t meshCount;
+      uint32_t materialCount;
+      uint32_t boneCount;
+      uint32_t flags;
+      uint32_t nodeCount;
+      uint32_t clipCount;
+      glm::vec3 minCoords;
+      glm::vec3 maxCoords;
+      glm::mat4 globInverseTransform;
+      uint64_t meshesOffset;
+      uint64_t materialsOffset;
+      uint64_t bonesOffset;
+      uint64_t nodesOffset;
+      uint64_t clipsOffset;
+      uint64_t stringsOffset;
+      uint64_t stringsSize;
+    };
+    
+    struct CookedMesh {
+      CookedString name;
+      uint32_t material;
+      uint32_t layout;
+      uint32_t indexType; // 0 = uint16, 1 = uint32
+      uint32_t vertexCount;
+      uint32_t indexCount;
+      uint32_t pad;
+      uint64_t positions;
+      uint64_t attributes;
+      uint64_t indices;
+    };
+    
+    struct CookedMaterial {
+      CookedString diffuse;
+    };
+    
+    struct CookedBone {
+      CookedString name;
+      glm::mat4 offset;
+    };
+    
+    // one SkeletonAsset node
+    struct CookedNode {
+      uint32_t parent;
+      int32_t bone;
+      glm::mat4 transform;
+    };
+    
+    // blobs of one AnimTrack, `first` holds nodeCount + 1 entries
+    struct CookedTrack {
+      uint32_t keyCount;
+      uint32_t pad;
+      uint64_t first;
+      uint64_t times;
+      uint64_t values;
+    };
+    
+    struct CookedClip {
+      CookedString name;
+      float duration;
+      float ticksPerSecond;
+      CookedTrack positions;
+      CookedTrack rotations;
+      CookedTrack scales;
+    };
+    
+    static_assert(std::is_trivially_copyable_v<CookedHeader> && std::is_trivially_copyable_v<CookedMesh> && std::is_trivially_copyable_v<CookedBone>);
+    static_assert(std::is_trivially_copyable_v<CookedNode> && std::is_trivially_copyable_v<CookedClip>);
+    
+    struct SourceStamp {
+      uint64_t size{0};
+      int64_t time{0};
+    };
+    
+    bool getSourceStamp(const std::string& path, SourceStamp& stamp) {
+      std::error_code ec;
+      auto size = std::filesystem::file_size(path, ec);
+      if(ec) return false;
+      auto time = std::filesystem::last_write_time(path, ec);
+      if(ec) return false;
+      
+      stamp.size = size;
+      stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+      return true;
+    }
+    
+    uint64_t alignUp(uint64_t v, uint64_t align) {
+      return (v + align - 1) / align * align;
+    }
+    
+    // animation data is sampled every frame, it is copied out of the mapping rather than viewed
+    template<typename T>
+    std::vector<T> toVector(std::span<const std::byte> bytes) {
+      std::vector<T> res(bytes.size() / sizeof(T));
+      if(!res.empty()) std::memcpy(res.data(), bytes.data(), res.size() * sizeof(T));
+      return res;
+    }
+    
+    // cooked indices come straight from disk, one out of range would make the gpu read past the vertices
+    template<typename T>
+    bool indicesInRange(std::span<const std::byte> indices, uint32_t vertexCount) {
+      T maxIndex = 0;
+      for(size_t i = 0; i + sizeof(T) <= indices.size(); i += sizeof(T)) {
+        T index;
+        std::memcpy(&index, indices.data() + i, sizeof(T));
+        maxIndex = std::max(maxIndex, index);
+      }
+      return indices.empty() || maxIndex < vertexCount;
+    }
+    
+    //====================================================================================================
+    
+    using BoneMapping = std::map<std::string, uint32_t>;
+    
+    // bone ids are handed out in node order before the meshes fan out, so the result does not depend on scheduling
+    void collectBones(const aiMesh* pMesh, BoneMapping& mapping, std::vector<BoneAsset>& bones) {
+      for(uint32_t i = 0; i < pMesh->mNumBones; ++i) {
+        std::string boneName(pMesh->mBones[i]->mName.data);
+        if(mapping.contains(boneName)) continue;
+        
+        uint32_t boneIndex = static_cast<uint32_t>(bones.size());
+        if (boneIndex + 1 > MAX_BONES) {
+          Logger::error("FATAL: Number of bones ({}) exceeds MAX_BONES ({}). Increase MAX_BONES in vk_buffer.hpp and the shader.",
+                                    boneIndex + 1, MAX_BONES);
+          return; 
+        }
+        
+        bones.push_back({
+          .name = boneName,
+          .offset = AssimpToGlmMat4(pMesh->mBones[i]->mOffsetMatrix)
+        });
+        mapping[boneName] = boneIndex;
+      }
+    }
+    
+    void loadBones(const aiMesh* pMesh, std::vector<Vertex>& vertices, const BoneMapping& mapping) {
+      for(uint32_t i = 0; i < pMesh->mNumBones; ++i) {
+        auto it = mapping.find(pMesh->mBones[i]->mName.data);
+        if(it == mapping.end()) continue;
+        uint32_t boneIndex = it->second;
+        
+        for(uint32_t j = 0; j < pMesh->mBones[i]->mNumWeights; ++j) {
+          uint32_t vertexID = pMesh->mBones[i]->mWeights[j].mVertexId;
+          float weight = pMesh->mBones[i]->mWeights[j].mWeight;
+          
+          for(int k = 0; k < MAX_BONES_PER_VERTEX; ++k) {
+            if(vertices[vertexID].weights[k] == 0.f) {
+              vertices[vertexID].boneIDs[k] = boneIndex;
+              vertices[vertexID].weights[k] = weight;
+              break;
+            }
+          }
+        }
+      }
+      
+      // normalize weights
+      for(size_t i = 0; i < vertices.size(); ++i) {
+        float totalWeight = 0.0f;
+        for(int j = 0; j < MAX_BONES_PER_VERTEX; ++j) {
+          totalWeight += vertices[i].weights[j];
+        }
+        
+        if (totalWeight > 0.0f) {
+          for(int j = 0; j < MAX_BONES_PER_VERTEX; ++j) {
+            vertices[i].weights[j] /= totalWeight;
+          }
+        }
+      }
+    }
+    
+    // only reads the scene and the bone mapping, safe to run for several meshes at once
+    ConvertedMesh convertMesh(const aiMesh* mesh, const BoneMapping& mapping) {
+      std::vector<Vertex> vertices;
+      std::vector<uint32_t> indices;
+      
+      //vertices==================================================
+      vertices.reserve(mesh->mNumVertices);
+      for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+        Vertex vertex;
+        vertex.pos = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
+        
+        if (mesh->HasNormals()) {
+          vertex.clr = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
+        }
+        
+        if (mesh->mTextureCoords[0]) {
+          vertex.texCoord = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y};
+        } else {
+          vertex.texCoord = glm::vec2(0.0f, 0.0f);
+        }
+        vertices.emplace_back(vertex);
+      }
+      //vertices==================================================
+      
+      loadBones(mesh, vertices, mapping);
+      
+      //indices==================================================
+      indices.reserve(mesh->mNumFaces * 3);
+      for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        aiFace face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; j++) {
+          indices.emplace_back(face.mIndices[j]);
+        }
+      }
+      //indices==================================================
+      
+      // static meshes skip the bone attributes entirely
+      auto layout = mesh->HasBones() ? VertexLayout::eSkinned : VertexLayout::eStatic;
+      return convertVertices(mesh->mName.C_Str(), mesh->mMaterialIndex, layout, vertices, indices);
+    }
+    
+    void collectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes) {
+      for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+      }
+      for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        collectMeshes(node->mChildren[i], scene, meshes);
+      }
+    }
+    
+    template<typename T, typename Key, typename Convert>
+    void appendKeys(AnimTrack<T>& track, const Key* keys, uint32_t count, Convert convert) {
+      track.first.push_back(static_cast<uint32_t>(track.times.size()));
+      for(uint32_t i = 0; i < count; ++i) {
+        track.times.push_back(static_cast<float>(keys[i].mTime));
+        track.values.push_back(convert(keys[i].mValue));
+      }
+    }
+    
+    template<typename T>
+    void closeTrack(AnimTrack<T>& track) {
+      track.first.push_back(static_cast<uint32_t>(track.times.size()));
+    }
+    
+  } //namespace
+  
+  //====================================================================================================
+  
+  std::string getCookedPath(const std::string& sourcePath) {
+    return sourcePath + ".vmdl";
+  }
+  
+  ConvertedMesh convertVertices(
+    std::string name,
+    uint32_t material,
+    VertexLayout layout,
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices
+  ) {
+    
+    optimizeMesh(vertices, indices, name);
+    
+    ConvertedMesh res;
+    res.name = std::move(name);
+    res.material = material;
+    res.layout = layout;
+    res.vertexCount = static_cast<uint32_t>(vertices.size());
+    res.indexCount = static_cast<uint32_t>(indices.size());
+    res.indexType = getIndexType(res.vertexCount);
+    
+    for (const auto& vertex : vertices) {
+      res.minCoords = glm::min(res.minCoords, vertex.pos);
+      res.maxCoords = glm::max(res.maxCoords, vertex.pos);
+    }
+    
+    res.packed = packVertices(vertices, res.layout);
+    res.indices = packIndices(indices, res.indexType);
+    return res;
+  }
+  
+  void addMesh(ConvertedMesh&& mesh, ModelAsset& out) {
+    out.minCoords = glm::min(out.minCoords, mesh.minCoords);
+    out.maxCoords = glm::max(out.maxCoords, mesh.maxCoords);
+    
+    auto& storage = out.storage;
+    storage.emplace_back(std::move(mesh.packed.positions));
+    auto positions = std::span<const std::byte>(storage.back());
+    storage.emplace_back(std::move(mesh.packed.attributes));
+    auto attributes = std::span<const std::byte>(storage.back());
+    storage.emplace_back(std::move(mesh.indices));
+    auto indices = std::span<const std::byte>(storage.back());
+    
+    out.meshes.push_back({
+      .name = std::move(mesh.name),
+      .material = mesh.material,
+      .geometry = {
+        .layout = mesh.layout,
+        .indexType = mesh.indexType,
+        .vertexCount = mesh.vertexCount,
+        .indexCount = mesh.indexCount,
+        .positions = positions,
+        .attributes = attributes,
+        .indices = indices
+      }
+    });
+  }
+  
+  bool importModel(
+    Assimp::Importer& importer,
+    const std::string& path,
+    ModelAsset& out,
+    ThreadPool* workers,
+    const std::function<void(const ModelAsset&)>& onMaterials
+  ) {
+    
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+      Logger::error("ASSIMP: {}", importer.GetErrorString());
+      return false;
+    }
+    
+    out.globInverseTransform = glm::inverse(AssimpToGlmMat4(scene->mRootNode->mTransformation));
+    out.minCoords = glm::vec3(std::numeric_limits<float>::max());
+    out.maxCoords = glm::vec3(std::numeric_limits<float>::lowest());
+    out.hasAnims = scene->HasAnimations();
+    
+    out.materials.resize(scene->mNumMaterials);
+    for(uint32_t i = 0; i < scene->mNumMaterials; ++i) {
+      aiMaterial* mat = scene->mMaterials[i];
+      if(mat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
+        aiString str;
+        mat->GetTexture(aiTextureType_DIFFUSE, 0, &str);
+        out.materials[i].diffuse = str.C_Str();
+      }
+    }
+    
+    if(onMaterials) onMaterials(out);
+    
+    std::vector<const aiMesh*> meshes;
+    collectMeshes(scene->mRootNode, scene, meshes);
+    
+    BoneMapping boneMapping;
+    for(const auto* mesh : meshes) {
+      collectBones(mesh, boneMapping, out.bones);
+    }
+    
+    // meshes convert independently, results are merged back in node order
+    std::vector<std::future<ConvertedMesh>> jobs;
+    if(workers) {
+      jobs.reserve(meshes.size());
+      for(const auto* mesh : meshes) {
+        jobs.push_back(workers->add_task(convertMesh, mesh, std::cref(boneMapping)));
+      }
+    }
+    
+    for(size_t i = 0; i < meshes.size(); ++i) {
+      bool queued = i < jobs.size() && jobs[i].valid();
+      addMesh(queued ? jobs[i].get() : convertMesh(meshes[i], boneMapping), out);
+    }
+    
+    return true;
+  }
+  
+  void compileAnimations(const aiScene& scene, ModelAsset& out) {
+    SkeletonAsset& skel = out.skeleton;
+    skel = SkeletonAsset{};
+    out.clips.clear();
+    if(!scene.mRootNode) return;
+    
+    std::unordered_map<std::string_view, int32_t> boneIds;
+    for(size_t i = 0; i < out.bones.size(); ++i) {
+      boneIds.emplace(out.bones[i].name, static_cast<int32_t>(i));
+    }
+    
+    //skeleton==================================================
+    // the names point into the scene, only needed until the channels are bound
+    std::vector<std::string_view> nodeNames;
+    std::vector<std::pair<const aiNode*, uint32_t>> stack{{scene.mRootNode, SkeletonAsset::NO_PARENT}};
+    while(!stack.empty()) {
+      auto [node, parent] = stack.back();
+      stack.pop_back();
+      
+      uint32_t id = static_cast<uint32_t>(skel.parents.size());
+      std::string_view name(node->mName.data, node->mName.length);
+      auto bone = boneIds.find(name);
+      
+      skel.parents.push_back(parent);
+      skel.bones.push_back(bone != boneIds.end() ? bone->second : -1);
+      skel.transforms.push_back(AssimpToGlmMat4(node->mTransformation));
+      nodeNames.push_back(name);
+      
+      // reversed so the children keep their scene order
+      for(uint32_t i = node->mNumChildren; i-- > 0;) {
+        stack.push_back({node->mChildren[i], id});
+      }
+    }
+    uint32_t nodeCount = static_cast<uint32_t>(nodeNames.size());
+    //skeleton==================================================
+    
+    //clips==================================================
+    out.clips.reserve(scene.mNumAnimations);
+    for(uint32_t a = 0; a < scene.mNumAnimations; ++a) {
+      const aiAnimation* anim = scene.mAnimations[a];
+      AnimClipAsset& clip = out.clips.emplace_back();
+      clip.name = anim->mName.C_Str();
+      clip.duration = static_cast<float>(anim->mDuration);
+      clip.ticksPerSecond = anim->mTicksPerSecond != 0 ? static_cast<float>(anim->mTicksPerSecond) : 25.f;
+      
+      // the first channel of a name drives the node
+      std::unordered_map<std::string_view, const aiNodeAnim*> channels;
+      for(uint32_t c = 0; c < anim->mNumChannels; ++c) {
+        const aiNodeAnim* channel = anim->mChannels[c];
+        channels.emplace(std::string_view(channel->mNodeName.data, channel->mNodeName.length), channel);
+      }
+      
+      clip.positions.first.reserve(nodeCount + 1);
+      clip.rotations.first.reserve(nodeCount + 1);
+      clip.scales.first.reserve(nodeCount + 1);
+      for(uint32_t n = 0; n < nodeCount; ++n) {
+        auto it = channels.find(nodeNames[n]);
+        const aiNodeAnim* ch = it != channels.end() ? it->second : nullptr;
+        
+        appendKeys(clip.positions, ch ? ch->mPositionKeys : nullptr, ch ? ch->mNumPositionKeys : 0, AssimpToGlmVec3);
+        appendKeys(clip.rotations, ch ? ch->mRotationKeys : nullptr, ch ? ch->mNumRotationKeys : 0, AssimpToGlmQuat);
+        appendKeys(clip.scales, ch ? ch->mScalingKeys : nullptr, ch ? ch->mNumScalingKeys : 0, AssimpToGlmVec3);
+      }
+      closeTrack(clip.positions);
+      closeTrack(clip.rotations);
+      closeTrack(clip.scales);
+    }
+    //clips==================================================
+  }
+  
+  bool loadCookedModel(const std::string& cookedPath, const std::string& sourcePath, ModelAsset& out) {
+    
+    if(!out.file.open(cookedPath)) return false;
+    auto bytes = out.file.bytes();
+    
+    auto inBounds = [&](uint64_t offset, uint64_t size) {
+      return offset <= bytes.size() && size <= bytes.size() - offset;
+    };
+    
+    if(!inBounds(0, sizeof(CookedHeader))) return false;
+    CookedHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    
+    if(header.magic != COOKED_MAGIC || header.version != COOKED_VERSION) {
+      Logger::info("Cooked model {} has an old format, recooking", cookedPath);
+      return false;
+    }
+    
+    // a missing source is fine, the cook is all we need
+    SourceStamp stamp;
+    if(getSourceStamp(sourcePath, stamp) && (stamp.size != header.sourceSize || stamp.time != header.sourceTime)) {
+      Logger::info("Cooked model {} is older than its source, recooking", cookedPath);
+      return false;
+    }
+    
+    if(  !inBounds(header.meshesOffset, static_cast<uint64_t>(header.meshCount) * sizeof(CookedMesh))
+      || !inBounds(header.materialsOffset, static_cast<uint64_t>(header.materialCount) * sizeof(CookedMaterial))
+      || !inBounds(header.bonesOffset, static_cast<uint64_t>(header.boneCount) * sizeof(CookedBone))
+      || !inBounds(header.nodesOffset, static_cast<uint64_t>(header.nodeCount) * sizeof(CookedNode))
+      || !inBounds(header.clipsOffset, static_cast<uint64_t>(header.clipCount) * sizeof(CookedClip))
+      || !inBounds(header.stringsOffset, header.stringsSize)
+    ) {
+      Logger::error("Cooked model {} is truncated", cookedPath);
+      return false;
+    }
+    
+    // both importers stop at MAX_BONES, the bone palette has no room for more
+    bool valid = header.boneCount <= MAX_BONES;
+    auto readString = [&](CookedString s) {
+      if(static_cast<uint64_t>(s.offset) + s.length > header.stringsSize) {
+        valid = false;
+        return std::string();
+      }
+      return std::string(reinterpret_cast<const char*>(bytes.data() + header.stringsOffset + s.offset), s.length);
+    };
+    auto readBlob = [&](uint64_t offset, uint64_t size) {
+      if(!inBounds(offset, size)) {
+        valid = false;
+        return std::span<const std::byte>();
+      }
+      return bytes.subspan(offset, size);
+    };
+    // sample() indexes straight into the keys, the node ranges have to be in order and end at keyCount
+    auto readTrack = [&]<typename T>(const CookedTrack& cooked, AnimTrack<T>& track) {
+      track.first = toVector<uint32_t>(readBlob(cooked.first, (static_cast<uint64_t>(header.nodeCount) + 1) * sizeof(uint32_t)));
+      track.times = toVector<float>(readBlob(cooked.times, static_cast<uint64_t>(cooked.keyCount) * sizeof(float)));
+      track.values = toVector<T>(readBlob(cooked.values, static_cast<uint64_t>(cooked.keyCount) * sizeof(T)));
+      if(!valid || track.first.front() != 0 || track.first.back() != cooked.keyCount || !std::ranges::is_sorted(track.first)) {
+        valid = false;
+      }
+    };
+    
+    out.globInverseTransform = header.globInverseTransform;
+    out.minCoords = header.minCoords;
+    out.maxCoords = header.maxCoords;
+    out.hasAnims = (header.flags & COOKED_HAS_ANIMS) != 0;
+    
+    out.materials.resize(header.materialCount);
+    for(uint32_t i = 0; i < header.materialCount; ++i) {
+      CookedMaterial mat;
+      std::memcpy(&mat, bytes.data() + header.materialsOffset + i * sizeof(CookedMaterial), sizeof(mat));
+      out.materials[i].diffuse = readString(mat.diffuse);
+    }
+    
+    out.bones.resize(header.boneCount);
+    for(uint32_t i = 0; i < header.boneCount; ++i) {
+      CookedBone bone;
+      std::memcpy(&bone, bytes.data() + header.bonesOffset + i * sizeof(CookedBone), sizeof(bone));
+      out.bones[i].name = readString(bone.name);
+      out.bones[i].offset = bone.offset;
+    }
+    
+    SkeletonAsset& skel = out.skeleton;
+    skel.parents.resize(header.nodeCount);
+    skel.bones.resize(header.nodeCount);
+    skel.transforms.resize(header.nodeCount);
+    for(uint32_t i = 0; i < header.nodeCount; ++i) {
+      CookedNode node;
+      std::memcpy(&node, bytes.data() + header.nodesOffset + i * sizeof(CookedNode), sizeof(node));
+      // parents come first, bone ids index the bone table
+      if(  (node.parent != SkeletonAsset::NO_PARENT && node.parent >= i)
+        || node.bone < -1 || node.bone >= static_cast<int32_t>(header.boneCount)
+      ) {
+        valid = false;
+        break;
+      }
+      skel.parents[i] = node.parent;
+      skel.bones[i] = node.bone;
+      skel.transforms[i] = node.transform;
+    }
+    
+    out.clips.resize(header.clipCount);
+    for(uint32_t i = 0; i < header.clipCount && valid; ++i) {
+      CookedClip clip;
+      std::memcpy(&clip, bytes.data() + header.clipsOffset + i * sizeof(CookedClip), sizeof(clip));
+      out.clips[i].name = readString(clip.name);
+      out.clips[i].duration = clip.duration;
+      out.clips[i].ticksPerSecond = clip.ticksPerSecond;
+      readTrack(clip.positions, out.clips[i].positions);
+      readTrack(clip.rotations, out.clips[i].rotations);
+      readTrack(clip.scales, out.clips[i].scales);
+    }
+    
+    out.meshes.resize(header.meshCount);
+    for(uint32_t i = 0; i < header.meshCount; ++i) {
+      CookedMesh mesh;
+      std::memcpy(&mesh, bytes.data() + header.meshesOffset + i * sizeof(CookedMesh), sizeof(mesh));
+      
+      auto layout = static_cast<VertexLayout>(mesh.layout);
+      auto indexType = mesh.indexType == 0 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+      if(mesh.layout >= VERTEX_LAYOUT_COUNT || mesh.material >= header.materialCount) {
+        valid = false;
+        break;
+      }
+      
+      out.meshes[i] = {
+        .name = readString(mesh.name),
+        .material = mesh.material,
+        .geometry = {
+          .layout = layout,
+          .indexType = indexType,
+          .vertexCount = mesh.vertexCount,
+          .indexCount = mesh.indexCount,
+          .positions = readBlob(mesh.positions, static_cast<uint64_t>(mesh.vertexCount) * getPositionStride(layout)),
+          .attributes = readBlob(mesh.attributes, static_cast<uint64_t>(mesh.vertexCount) * sizeof(VertexAttributes)),
+          .indices = readBlob(mesh.indices, static_cast<uint64_t>(mesh.indexCount) * getIndexSize(indexType))
+        }
+      };
+      
+      const auto& geometry = out.meshes[i].geometry;
+      bool inRange = indexType == vk::IndexType::eUint16
+        ? indicesInRange<uint16_t>(geometry.indices, geometry.vertexCount)
+        : indicesInRange<uint32_t>(geometry.indices, geometry.vertexCount);
+      if(!inRange) {
+        valid = false;
+        break;
+      }
+    }
+    
+    if(!valid) {
+      Logger::error("Cooked model {} is corrupted, recooking", cookedPath);
+      out = ModelAsset{};
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool saveCookedModel(const std::string& cookedPath, const std::string& sourcePath, const ModelAsset& asset) {
+    
+    SourceStamp stamp;
+    if(!getSourceStamp(sourcePath, stamp)) {
+      Logger::error("Failed to stat {}", sourcePath);
+      return false;
+    }
+    
+    std::string strings;
+    auto addString = [&strings](const std::string& s) {
+      CookedString res{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.size())};
+      strings += s;
+      return res;
+    };
+    
+    CookedHeader header{
+      .magic = COOKED_MAGIC,
+      .version = COOKED_VERSION,
+      .sourceSize = stamp.size,
+      .sourceTime = stamp.time,
+      .meshCount = static_cast<uint32_t>(asset.meshes.size()),
+      .materialCount = static_cast<uint32_t>(asset.materials.size()),
+      .boneCount = static_cast<uint32_t>(asset.bones.size()),
+      .flags = asset.hasAnims ? COOKED_HAS_ANIMS : 0u,
+      .nodeCount = static_cast<uint32_t>(asset.skeleton.parents.size()),
+      .clipCount = static_cast<uint32_t>(asset.clips.size()),
+      .minCoords = asset.minCoords,
+      .maxCoords = asset.maxCoords,
+      .globInverseTransform = asset.globInverseTransform
+    };
+    
+    header.meshesOffset = alignUp(sizeof(CookedHeader), 8);
+    header.materialsOffset = header.meshesOffset + header.meshCount * sizeof(CookedMesh);
+    header.bonesOffset = header.materialsOffset + header.materialCount * sizeof(CookedMaterial);
+    header.nodesOffset = header.bonesOffset + header.boneCount * sizeof(CookedBone);
+    header.clipsOffset = header.nodesOffset + header.nodeCount * sizeof(CookedNode);
+    uint64_t dataOffset = alignUp(header.clipsOffset + header.clipCount * sizeof(CookedClip), COOKED_ALIGN);
+    
+    std::vector<std::byte> data(dataOffset);
+    auto addBlob = [&data](std::span<const std::byte> blob) {
+      uint64_t offset = alignUp(data.size(), COOKED_ALIGN);
+      data.resize(offset + blob.size());
+      std::memcpy(data.data() + offset, blob.data(), blob.size());
+      return offset;
+    };
+    auto addTrack = [&addBlob](const auto& track) {
+      return CookedTrack{
+        .keyCount = static_cast<uint32_t>(track.times.size()),
+        .pad = 0,
+        .first = addBlob(std::as_bytes(std::span(track.first))),
+        .times = addBlob(std::as_bytes(std::span(track.times))),
+        .values = addBlob(std::as_bytes(std::span(track.values)))
+      };
+    };
+    
+    std::vector<CookedMesh> meshes;
+    meshes.reserve(asset.meshes.size());
+    for(const auto& mesh : asset.meshes) {
+      const auto& g = mesh.geometry;
+      meshes.push_back({
+        .name = addString(mesh.name),
+        .material = mesh.material,
+        .layout = static_cast<uint32_t>(g.layout),
+        .indexType = g.indexType == vk::IndexType::eUint16 ? 0u : 1u,
+        .vertexCount = g.vertexCount,
+        .indexCount = g.indexCount,
+        .pad = 0,
+        .positions = addBlob(g.positions),
+        .attributes = addBlob(g.attributes),
+        .indices = addBlob(g.indices)
+      });
+    }
+    
+    std::vector<CookedMaterial> materials;
+    for(const auto& mat : asset.materials) {
+      materials.push_back({addString(mat.diffuse)});
+    }
+    
+    std::vector<CookedBone> bones;
+    for(const auto& bone : asset.bones) {
+      bones.push_back({addString(bone.name), bone.offset});
+    }
+    
+    const SkeletonAsset& skel = asset.skeleton;
+    std::vector<CookedNode> nodes;
+    nodes.reserve(header.nodeCount);
+    for(uint32_t i = 0; i < header.nodeCount; ++i) {
+      nodes.push_back({skel.parents[i], skel.bones[i], skel.transforms[i]});
+    }
+    
+    std::vector<CookedClip> clips;
+    clips.reserve(header.clipCount);
+    for(const auto& clip : asset.clips) {
+      clips.push_back({
+        .name = addString(clip.name),
+        .duration = clip.duration,
+        .ticksPerSecond = clip.ticksPerSecond,
+        .positions = addTrack(clip.positions),
+        .rotations = addTrack(clip.rotations),
+        .scales = addTrack(clip.scales)
+      });
+    }
+    
+    header.stringsOffset = data.size();
+    header.stringsSize = strings.size();
+    data.resize(data.size() + strings.size());
+    
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + header.meshesOffset, meshes.data(), meshes.size() * sizeof(CookedMesh));
+    std::memcpy(data.data() + header.materialsOffset, materials.data(), materials.size() * sizeof(CookedMaterial));
+    std::memcpy(data.data() + header.bonesOffset, bones.data(), bones.size() * sizeof(CookedBone));
+    std::memcpy(data.data() + header.nodesOffset, nodes.data(), nodes.size() * sizeof(CookedNode));
+    std::memcpy(data.data() + header.clipsOffset, clips.data(), clips.size() * sizeof(CookedClip));
+    std::memcpy(data.data() + header.stringsOffset, strings.data(), strings.size());
+    
+    // written aside and renamed, a crash mid-write never leaves a half cook behind
+    std::string tmpPath = cookedPath + ".tmp";
+    {
+      std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+      if(!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        Logger::error("Failed to write cooked model {}", tmpPath);
+        return false;
+      }
+    }
+    
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cookedPath, ec);
+    if(ec) {
+      Logger::error("Failed to write cooked model {}: {}", cookedPath, ec.message());
+      std::filesystem::remove(tmpPath, ec);
+      return false;
+    }
+    
+    Logger::info("Cooked model: {} ({:.2f} MB)", cookedPath, static_cast<float>(data.size()) / (1024.f * 1024.f));
+    return true;
+  }
+  
+}; //V
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "vk_geometry.hpp"
+#include "../../tools/mappedFile/mapped_file.hpp"
+#include "../../tools/threadPool/threadpool.hpp"
+
+namespace Assimp {
+  class Importer;
+}
+struct aiScene;
+
+namespace V {
+  
+  struct MeshAsset {
+    std::string name;
+    uint32_t material{0};
+    GeometryView geometry;
+  };
+  
+  struct MaterialAsset {
+    std::string diffuse; // texture path as written in the source file, empty if none
+  };
+  
+  struct BoneAsset {
+    std::string name;
+    glm::mat4 offset{1.f};
+  };
+  
+  // the node tree flattened depth-first, a parent always has a lower index than its children
+  struct SkeletonAsset {
+    static constexpr uint32_t NO_PARENT = ~0u;
+    
+    std::vector<uint32_t> parents;
+    std::vector<int32_t> bones;        // bone id the node drives, -1 if none
+    std::vector<glm::mat4> transforms; // local transform while no channel animates the node
+  };
+  
+  // one key type of a clip for every node: the keys of node n are [first[n], first[n + 1])
+  template<typename T>
+  struct AnimTrack {
+    std::vector<uint32_t> first;
+    std::vector<float> times;
+    std::vector<T> values;
+    
+    bool has(uint32_t node) const { return first[node] != first[node + 1]; }
+    
+    // clamped to the first and last key, `fallback` if the track leaves the node alone
+    T sample(uint32_t node, float time, const T& fallback) const {
+      uint32_t begin = first[node];
+      uint32_t end = first[node + 1];
+      if(begin == end) return fallback;
+      
+      uint32_t next = static_cast<uint32_t>(std::upper_bound(times.begin() + begin, times.begin() + end, time) - times.begin());
+      if(next == begin) return values[begin];
+      if(next == end) return values[end - 1];
+      
+      uint32_t prev = next - 1;
+      float factor = (time - times[prev]) / (times[next] - times[prev]);
+      if constexpr(std::is_same_v<T, glm::quat>) return glm::slerp(values[prev], values[next], factor);
+      else return glm::mix(values[prev], values[next], factor);
+    }
+  };
+  
+  struct AnimClipAsset {
+    std::string name;
+    float duration{0.f}; // in ticks
+    float ticksPerSecond{25.f};
+    AnimTrack<glm::vec3> positions;
+    AnimTrack<glm::quat> rotations;
+    AnimTrack<glm::vec3> scales;
+  };
+  
+  // everything VulkanModel needs from a model file, GPU-ready;
+  // the geometry views point into the mapped cooked file or into `storage` after an import
+  struct ModelAsset {
+    std::vector<MeshAsset> meshes;
+    std::vector<MaterialAsset> materials;
+    std::vector<BoneAsset> bones; // index = bone id in the vertex data
+    glm::mat4 globInverseTransform{1.f};
+    glm::vec3 minCoords{0.f};
+    glm::vec3 maxCoords{0.f};
+    bool hasAnims{false};
+    // cooked with the rest; compileAnimations() or importGltf() fill them on import
+    SkeletonAsset skeleton;
+    std::vector<AnimClipAsset> clips;
+    
+    MappedFile file;
+    std::vector<std::vector<std::byte>> storage;
+  };
+  
+  // the cooked file sits next to the source: MESH_Chest.fbx -> MESH_Chest.fbx.vmdl
+  std::string getCookedPath(const std::string& sourcePath);
+  
+  // one mesh after conversion, owns its blobs until addMesh() moves them into the asset
+  struct ConvertedMesh {
+    std::string name;
+    uint32_t material{0};
+    VertexLayout layout{VertexLayout::eStatic};
+    vk::IndexType indexType{vk::IndexType::eUint32};
+    uint32_t vertexCount{0};
+    uint32_t indexCount{0};
+    PackedVertices packed;
+    std::vector<std::byte> indices;
+    glm::vec3 minCoords{std::numeric_limits<float>::max()};
+    glm::vec3 maxCoords{std::numeric_limits<float>::lowest()};
+  };
+  
+  // mesh optimization and vertex packing shared by the importers, safe to run for several meshes at once
+  ConvertedMesh convertVertices(
+    std::string name,
+    uint32_t material,
+    VertexLayout layout,
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices
+  );
+  // grows the asset's bounds, the views point into out.storage
+  void addMesh(ConvertedMesh&& mesh, ModelAsset& out);
+  
+  // full Assimp import: triangulation, normals, bones, mesh optimization and vertex packing,
+  // meshes are converted on `workers` when given; the scene stays owned by the importer so animations can still be sampled from it
+  // onMaterials runs once the material table is filled, before the meshes convert
+  bool importModel(
+    Assimp::Importer& importer,
+    const std::string& path,
+    ModelAsset& out,
+    ThreadPool* workers = nullptr,
+    const std::function<void(const ModelAsset&)>& onMaterials = {}
+  );
+  
+  // .gltf / .glb without Assimp: the file is parsed once and mapped, accessors are read straight into the
+  // packed layouts. Node transforms are baked into static meshes, skeleton and clips are compiled from the document.
+  // embedded images are extracted next to the file once and then load like external ones
+  bool importGltf(
+    const std::string& path,
+    ModelAsset& out,
+    ThreadPool* workers = nullptr,
+    const std::function<void(const ModelAsset&)>& onMaterials = {}
+  );
+  bool isGltfPath(const std::string& path);
+  
+  // Assimp's node tree and clips into index-addressed arrays, nodes bind to bones and channels by name once here;
+  // the scene is not needed for sampling afterwards
+  void compileAnimations(const aiScene& scene, ModelAsset& out);
+  
+  // fails if the cooked file is missing, from another format version or older than the source
+  bool loadCookedModel(const std::string& cookedPath, const std::string& sourcePath, ModelAsset& out);
+  bool saveCookedModel(const std::string& cookedPath, const std::string& sourcePath, const ModelAsset& asset);
+  
+}; //V
@@ -1,4 +1,3 @@
-#include "vk_swapchain.hpp"
 #include "vk_pipeline.hpp"
 #include "vk_vertex.hpp"
 #include "vk_ubo.hpp"
@@ -14,111 +13,61 @@ namespace V {
     
   }
   
-  
-  std::optional<std::vector<char>> VulkanPipeline::readFile(const std::string_view filename) {
-    std::ifstream file(filename.data(), std::ios::ate | std::ios::binary);
-    
-    if(!file.is_open()) {
-      Logger::error("Failed to open file: {}", filename);
-      return std::nullopt;
-    }
-    
-    std::vector<char> buffer(file.tellg());
-    
-    file.seekg(0, std::ios::beg);
-    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
-    file.close();
-    
-    return buffer;
-  }
-  
-  [[nodiscard]] std::optional<vk::raii::ShaderModule> VulkanPipeline::createShaderModule(const vk::raii::Device& dev, const std::vector<char>& code) const {
-    vk::ShaderModuleCreateInfo createInfo{
-      .codeSize = code.size() * sizeof(char),
-      .pCode = reinterpret_cast<const uint32_t*>(code.data())
-    };
-    
-    auto res = dev.createShaderModule(createInfo);
-    if(!res) {
-      Logger::error("Failed to create shader module: {}", vk::to_string(res.error()));
-      return std::nullopt;
-    }
-    auto shaderModule = std::move(res.value());
-    
-    return shaderModule;
-  }
-  
   bool VulkanPipeline::init(
-    const vk::raii::Device& logDev,
-    VulkanSwapchain& sc,
-    vk::PipelineLayoutCreateInfo& info,
-    vk::Format format,
-    const VulkanPplConfig& config
+    const vk::raii::ShaderModule& shaderModule,
+    std::shared_ptr<vk::raii::PipelineLayout> layout,
+    const VulkanPplKey& key
   ) {
     
-    std::vector<char> shaderCode;
-    vk::raii::ShaderModule shaderModule{nullptr};
-    
-    {
-      auto res = readFile(config.shaderPath);
-      if(!res) {
-        return false;
-      }
-      shaderCode = res.value();
-    }
-      
-    {
-      auto res = createShaderModule(logDev, shaderCode);
-      if(!res) {
-        return false;
-      }
-      shaderModule = std::move(res.value());
-    }
+    const VulkanPplConfig& config = key.config;
+    m_pipelineLayout = std::move(layout);
+    m_build = std::make_unique<BuildState>();
+    BuildState& b = *m_build;
     
-    vk::PipelineShaderStageCreateInfo vertShaderStageInfo{
+    b.stages[0] = vk::PipelineShaderStageCreateInfo{
       .stage = vk::ShaderStageFlagBits::eVertex,
       .module = shaderModule,
-      .pName = "vertMain"
+      .pName = getVertexEntry(config.vertexLayout, config.vertexStreams).data()
     };
     
-    vk::PipelineShaderStageCreateInfo fragShaderStageInfo{
+    b.stages[1] = vk::PipelineShaderStageCreateInfo{
       .stage = vk::ShaderStageFlagBits::eFragment,
       .module = shaderModule,
       .pName = "fragMain"
     };
     
-    vk::PipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+    bool depthOnly = !hasStream(config.vertexStreams, VertexStreams::eAttributes);
     
-    auto bindingDesc = Vertex::getBindingDescription();
-    auto attrDesc = Vertex::getAttribDescription();
-    vk::PipelineVertexInputStateCreateInfo vertInputInfo{
-      .vertexBindingDescriptionCount = 1,
-      .pVertexBindingDescriptions = &bindingDesc,
-      .vertexAttributeDescriptionCount = attrDesc.size(),
-      .pVertexAttributeDescriptions = attrDesc.data()
+    b.bindingDesc = getBindingDescription(config.vertexLayout, config.vertexStreams);
+    b.attrDesc = getAttribDescription(config.vertexLayout, config.vertexStreams);
+    b.vertInputInfo = vk::PipelineVertexInputStateCreateInfo{
+      .vertexBindingDescriptionCount = static_cast<uint32_t>(b.bindingDesc.size()),
+      .pVertexBindingDescriptions = b.bindingDesc.data(),
+      .vertexAttributeDescriptionCount = static_cast<uint32_t>(b.attrDesc.size()),
+      .pVertexAttributeDescriptions = b.attrDesc.data()
     };
     
-    vk::PipelineInputAssemblyStateCreateInfo inputAssembly{
+    b.inputAssembly = vk::PipelineInputAssemblyStateCreateInfo{
       .topology = config.topology,
       .primitiveRestartEnable = vk::False
     };
     
-    std::vector<vk::DynamicState> dynStates = {
+    b.dynStates = {
       vk::DynamicState::eViewport,
       vk::DynamicState::eScissor
     };
     
-    vk::PipelineDynamicStateCreateInfo dynamicState{
-      .dynamicStateCount = static_cast<uint32_t>(dynStates.size()),
-      .pDynamicStates = dynStates.data()
+    b.dynamicState = vk::PipelineDynamicStateCreateInfo{
+      .dynamicStateCount = static_cast<uint32_t>(b.dynStates.size()),
+      .pDynamicStates = b.dynStates.data()
     };
     
-    vk::PipelineViewportStateCreateInfo viewportState{
+    b.viewportState = vk::PipelineViewportStateCreateInfo{
       .viewportCount = 1,
       .scissorCount = 1
     };
     
-    vk::PipelineRasterizationStateCreateInfo rasterizer{
+    b.rasterizer = vk::PipelineRasterizationStateCreateInfo{
       .depthClampEnable = vk::False,
       .rasterizerDiscardEnable = vk::False,
       .polygonMode = config.polygonMode,
@@ -129,12 +78,12 @@ namespace V {
       .lineWidth = 1.f
     };
     
-    vk::PipelineMultisampleStateCreateInfo multisampling{
+    b.multisampling = vk::PipelineMultisampleStateCreateInfo{
       .rasterizationSamples = vk::SampleCountFlagBits::e1,
       .sampleShadingEnable = vk::False
     };
     
-    vk::PipelineDepthStencilStateCreateInfo depthStencil{
+    b.depthStencil = vk::PipelineDepthStencilStateCreateInfo{
       .depthTestEnable = config.depthTestEnable,
       .depthWriteEnable = config.depthWriteEnable,
       .depthCompareOp = config.depthCompOp,
@@ -142,71 +91,67 @@ namespace V {
       .stencilTestEnable = vk::False
     };
     
-    vk::PipelineColorBlendAttachmentState clrBlendAttachment{
+    b.clrBlendAttachment = vk::PipelineColorBlendAttachmentState{
       .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
     };
+    if(depthOnly) {
+      b.clrBlendAttachment.colorWriteMask = {};
+    }
     
     if(config.alphaBlend) {
-      clrBlendAttachment.blendEnable = vk::True;
-      clrBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-      clrBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-      clrBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
-      clrBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
-      clrBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
-      clrBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
+      b.clrBlendAttachment.blendEnable = vk::True;
+      b.clrBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+      b.clrBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+      b.clrBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+      b.clrBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+      b.clrBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+      b.clrBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
     } else {
-      clrBlendAttachment.blendEnable = vk::False;
+      b.clrBlendAttachment.blendEnable = vk::False;
     }
     
-    vk::PipelineColorBlendStateCreateInfo clrBlending{
+    b.clrBlending = vk::PipelineColorBlendStateCreateInfo{
       .logicOpEnable = vk::False,
       .logicOp = vk::LogicOp::eCopy,
       .attachmentCount = 1,
-      .pAttachments = &clrBlendAttachment
+      .pAttachments = &b.clrBlendAttachment
     };
     
-    {
-      auto res = logDev.createPipelineLayout(info);
-      if(!res) {
-        Logger::error("Failed to create pipeline layout: {}", vk::to_string(res.error()));
-        return false;
-      }
-      m_pipelineLayout = std::move(res.value());
-    }
-    
-    vk::PipelineRenderingCreateInfo pipRenderCreateInfo{
+    b.colorFormat = key.colorFormat;
+    b.pipRenderCreateInfo = vk::PipelineRenderingCreateInfo{
       .colorAttachmentCount = 1,
-      .pColorAttachmentFormats = &sc.getFormat(),
-      .depthAttachmentFormat = format
+      .pColorAttachmentFormats = &b.colorFormat,
+      .depthAttachmentFormat = key.depthFormat
     };
     
-    
-    vk::GraphicsPipelineCreateInfo pipInfo{
-      .pNext = &pipRenderCreateInfo,
-      .stageCount = 2,
-      .pStages = shaderStages,
-      .pVertexInputState = &vertInputInfo,
-      .pInputAssemblyState = &inputAssembly,
-      .pViewportState = &viewportState,
-      .pRasterizationState = &rasterizer,
-      .pMultisampleState = &multisampling,
-      .pDepthStencilState = &depthStencil,
-      .pColorBlendState = &clrBlending,
-      .pDynamicState = &dynamicState,
-      .layout = m_pipelineLayout,
+    b.createInfo = vk::GraphicsPipelineCreateInfo{
+      .pNext = &b.pipRenderCreateInfo,
+      .stageCount = depthOnly ? 1u : 2u,
+      .pStages = b.stages,
+      .pVertexInputState = &b.vertInputInfo,
+      .pInputAssemblyState = &b.inputAssembly,
+      .pViewportState = &b.viewportState,
+      .pRasterizationState = &b.rasterizer,
+      .pMultisampleState = &b.multisampling,
+      .pDepthStencilState = &b.depthStencil,
+      .pColorBlendState = &b.clrBlending,
+      .pDynamicState = &b.dynamicState,
+      .layout = *m_pipelineLayout,
       .renderPass = nullptr
     };
-      
-    {
-      auto res = logDev.createGraphicsPipeline(nullptr, pipInfo);
-      if(!res) {
-        Logger::error("Failed to create graphics pipeline: {}", vk::to_string(res.error()));
-        return false;
-      }
-      m_pipeline = std::move(res.value());
-    }
     
     return true;
   }
   
+  void VulkanPipeline::setPipeline(vk::raii::Pipeline&& pipeline) {
+    m_pipeline = std::move(pipeline);
+    m_build.reset();
+    m_state.store(State::eReady, std::memory_order_release);
+  }
+  
+  void VulkanPipeline::setFailed() {
+    m_build.reset();
+    m_state.store(State::eFailed, std::memory_order_release);
+  }
+  
 }; //V
\ No newline at end of file
@@ -1,12 +1,19 @@
 #pragma once
 
-#include "vk_types.hpp"
+#include "vk_vertex.hpp"
+#include "vk_shader_cache.hpp"
+#include "vk_pipeline_cache.hpp"
+
+#include <atomic>
 
 namespace V {
   
   struct VulkanPplConfig {
     
     std::string_view shaderPath;
+    VertexLayout vertexLayout = VertexLayout::eStatic;
+    // position-only pipelines run without a fragment stage and write depth only
+    VertexStreams vertexStreams = VertexStreams::eAll;
     
     vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
     
@@ -20,9 +27,47 @@ namespace V {
     bool depthWriteEnable = true;
     vk::CompareOp depthCompOp = vk::CompareOp::eLess;
     
+    bool operator==(const VulkanPplConfig&) const = default;
+    
+  };
+  
+  // by value and stable across runs, two configs naming the same shader file hash the same
+  struct VulkanPplConfigHash {
+    size_t operator()(const VulkanPplConfig& config) const {
+      size_t seed = static_cast<size_t>(hashBytes(std::as_bytes(std::span(config.shaderPath))));
+      hashCombine(seed, static_cast<size_t>(config.vertexLayout));
+      hashCombine(seed, static_cast<size_t>(config.vertexStreams));
+      hashCombine(seed, static_cast<size_t>(config.topology));
+      hashCombine(seed, static_cast<size_t>(config.polygonMode));
+      hashCombine(seed, static_cast<size_t>(static_cast<VkCullModeFlags>(config.cullMode)));
+      hashCombine(seed, static_cast<size_t>(config.frontface));
+      hashCombine(seed, config.alphaBlend);
+      hashCombine(seed, config.depthTestEnable);
+      hashCombine(seed, config.depthWriteEnable);
+      hashCombine(seed, static_cast<size_t>(config.depthCompOp));
+      return seed;
+    }
   };
   
-  class VulkanSwapchain;
+  // everything a graphics pipeline is built from besides the shared layout
+  struct VulkanPplKey {
+    VulkanPplConfig config;
+    vk::Format colorFormat = vk::Format::eUndefined;
+    vk::Format depthFormat = vk::Format::eUndefined;
+    uint64_t shaderHash = 0; // content of config.shaderPath, a rebuilt .spv gets its own pipeline
+    
+    bool operator==(const VulkanPplKey&) const = default;
+  };
+  
+  struct VulkanPplKeyHash {
+    size_t operator()(const VulkanPplKey& key) const {
+      size_t seed = VulkanPplConfigHash{}(key.config);
+      hashCombine(seed, static_cast<size_t>(key.colorFormat));
+      hashCombine(seed, static_cast<size_t>(key.depthFormat));
+      hashCombine(seed, static_cast<size_t>(key.shaderHash));
+      return seed;
+    }
+  };
   
   class VulkanPipeline {
   public:
@@ -30,18 +75,55 @@ namespace V {
     VulkanPipeline();
     ~VulkanPipeline();
     
-    bool init(const vk::raii::Device&, VulkanSwapchain&, vk::PipelineLayoutCreateInfo&, vk::Format, const VulkanPplConfig&);
+    // captures everything vkCreateGraphicsPipelines reads, the pipeline itself is built later by the registry.
+    // the layout is shared by every pipeline of the registry, the module has to outlive the build
+    bool init(const vk::raii::ShaderModule& shaderModule, std::shared_ptr<vk::raii::PipelineLayout> layout, const VulkanPplKey& key);
+    
+    // points into the pipeline's own state, valid until setPipeline() or setFailed()
+    const vk::GraphicsPipelineCreateInfo& getCreateInfo() const { return m_build->createInfo; }
+    // called once from whichever thread built it, the captured state is released
+    void setPipeline(vk::raii::Pipeline&& pipeline);
+    void setFailed();
+    
+    // draws have to skip the pipeline until it is ready
+    bool isReady() const { return m_state.load(std::memory_order_acquire) == State::eReady; }
+    bool isFailed() const { return m_state.load(std::memory_order_acquire) == State::eFailed; }
     
     vk::raii::Pipeline& getPipeline() { return m_pipeline; }
-    vk::raii::PipelineLayout& getPipLayout() { return m_pipelineLayout; }
+    vk::raii::PipelineLayout& getPipLayout() { return *m_pipelineLayout; }
     
   private:
     
-    static std::optional<std::vector<char>> readFile(const std::string_view filename);
-    [[nodiscard]] std::optional<vk::raii::ShaderModule> createShaderModule(const vk::raii::Device& dev, const std::vector<char>& code) const;
+    enum class State : uint8_t {
+      eCompiling,
+      eReady,
+      eFailed
+    };
+    
+    // the create info points into the rest, so it lives behind a pointer and never moves
+    struct BuildState {
+      vk::PipelineShaderStageCreateInfo stages[2];
+      std::vector<vk::VertexInputBindingDescription> bindingDesc;
+      std::vector<vk::VertexInputAttributeDescription> attrDesc;
+      vk::PipelineVertexInputStateCreateInfo vertInputInfo;
+      vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+      std::array<vk::DynamicState, 2> dynStates;
+      vk::PipelineDynamicStateCreateInfo dynamicState;
+      vk::PipelineViewportStateCreateInfo viewportState;
+      vk::PipelineRasterizationStateCreateInfo rasterizer;
+      vk::PipelineMultisampleStateCreateInfo multisampling;
+      vk::PipelineDepthStencilStateCreateInfo depthStencil;
+      vk::PipelineColorBlendAttachmentState clrBlendAttachment;
+      vk::PipelineColorBlendStateCreateInfo clrBlending;
+      vk::Format colorFormat;
+      vk::PipelineRenderingCreateInfo pipRenderCreateInfo;
+      vk::GraphicsPipelineCreateInfo createInfo;
+    };
     
     vk::raii::Pipeline m_pipeline{nullptr};
-    vk::raii::PipelineLayout m_pipelineLayout{nullptr};
+    std::shared_ptr<vk::raii::PipelineLayout> m_pipelineLayout;
+    std::unique_ptr<BuildState> m_build;
+    std::atomic<State> m_state{State::eCompiling};
     
   };
   
@@ -0,0 +1,98 @@
+#include "vk_pipeline_cache.hpp"
+#include "../../tools/mappedFile/mapped_file.hpp"
+
+#include <filesystem>
+#include <cstring>
+
+namespace V {
+  
+  VulkanPipelineCache::VulkanPipelineCache() {
+    
+  }
+  
+  VulkanPipelineCache::~VulkanPipelineCache() {
+    
+  }
+  
+  bool VulkanPipelineCache::init(vk::raii::PhysicalDevice& pDev, vk::raii::Device& lDev, const std::string& path) {
+    
+    m_path = path;
+    
+    MappedFile file;
+    std::span<const std::byte> seed;
+    if(file.open(path)) {
+      if(validate(file.bytes(), pDev.getProperties())) {
+        seed = file.bytes();
+      } else {
+        Logger::warn("Pipeline cache {} was written for another device or driver, starting cold", path);
+      }
+    }
+    
+    vk::PipelineCacheCreateInfo info{
+      .initialDataSize = seed.size(),
+      .pInitialData = seed.data()
+    };
+    
+    auto res = lDev.createPipelineCache(info);
+    if(!res) {
+      Logger::error("Failed to create pipeline cache: {}", vk::to_string(res.error()));
+      return false;
+    }
+    m_cache = std::move(res.value());
+    m_warm = !seed.empty();
+    
+    Logger::info("Pipeline cache: {} ({} bytes from {})", m_warm ? "warm" : "cold", seed.size(), path);
+    return true;
+  }
+  
+  bool VulkanPipelineCache::save() const {
+    if(!*m_cache) return false;
+    
+    std::vector<uint8_t> data = m_cache.getData();
+    if(data.empty()) return false;
+    
+    std::string tmpPath = m_path + ".tmp";
+    {
+      std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+      if(!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        Logger::error("Failed to write pipeline cache {}", tmpPath);
+        return false;
+      }
+    }
+    
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, m_path, ec);
+    if(ec) {
+      Logger::error("Failed to write pipeline cache {}: {}", m_path, ec.message());
+      std::filesystem::remove(tmpPath, ec);
+      return false;
+    }
+    
+    Logger::info("Pipeline cache saved: {} ({} bytes)", m_path, data.size());
+    return true;
+  }
+  
+  bool VulkanPipelineCache::validate(std::span<const std::byte> data, const vk::PhysicalDeviceProperties& props) {
+    
+    struct Header {
+      uint32_t headerSize;
+      uint32_t headerVersion;
+      uint32_t vendorID;
+      uint32_t deviceID;
+      uint8_t uuid[vk::UuidSize];
+    };
+    static_assert(sizeof(Header) == 32);
+    
+    if(data.size() < sizeof(Header)) return false;
+    
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    
+    return header.headerSize >= sizeof(Header) && header.headerSize <= data.size()
+      && header.headerVersion == static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne)
+      && header.vendorID == props.vendorID
+      && header.deviceID == props.deviceID
+      && std::memcmp(header.uuid, props.pipelineCacheUUID.data(), vk::UuidSize) == 0;
+  }
+  
+}; //V
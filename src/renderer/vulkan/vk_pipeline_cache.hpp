@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+namespace V {
+  
+  // driver pipeline cache kept across launches; a file written by another driver or GPU is ignored
+  class VulkanPipelineCache {
+  public:
+    
+    VulkanPipelineCache();
+    ~VulkanPipelineCache();
+    
+    VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+    VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+    
+    bool init(vk::raii::PhysicalDevice& pDev, vk::raii::Device& lDev, const std::string& path);
+    // written aside and renamed, so a crash mid-write keeps the previous file
+    bool save() const;
+    
+    vk::raii::PipelineCache& getCache() { return m_cache; }
+    // seeded from disk, pipelines are expected to come out of it without a full compile
+    bool isWarm() const { return m_warm; }
+  
+  private:
+    
+    // VkPipelineCacheHeaderVersionOne against the device the cache is created on
+    static bool validate(std::span<const std::byte> data, const vk::PhysicalDeviceProperties& props);
+    
+    std::string m_path;
+    vk::raii::PipelineCache m_cache{nullptr};
+    bool m_warm{false};
+    
+  };
+  
+}; //V
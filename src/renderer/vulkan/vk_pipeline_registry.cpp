@@ -0,0 +1,144 @@
+#include "vk_pipeline_registry.hpp"
+#include "vk_swapchain.hpp"
+#include "vk_image.hpp"
+
+namespace V {
+  
+  VulkanPipelineRegistry::VulkanPipelineRegistry() {
+    
+  }
+  
+  VulkanPipelineRegistry::~VulkanPipelineRegistry() {
+    wait();
+  }
+  
+  bool VulkanPipelineRegistry::init(
+    vk::raii::PhysicalDevice& pDev,
+    vk::raii::Device& lDev,
+    VulkanSwapchain& sc,
+    VulkanShaderCache& shaders,
+    VulkanPipelineCache& pplCache,
+    ThreadPool& workers,
+    std::span<const vk::DescriptorSetLayout> setLayouts
+  ) {
+    
+    m_lDev = &lDev;
+    m_sc = &sc;
+    m_shaders = &shaders;
+    m_pplCache = &pplCache;
+    m_workers = &workers;
+    
+    if(!findDepthFormat(m_depthFormat, pDev)) return false;
+    
+    vk::PipelineLayoutCreateInfo plInfo{
+      .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+      .pSetLayouts = setLayouts.data()
+    };
+    
+    auto res = lDev.createPipelineLayout(plInfo);
+    if(!res) {
+      Logger::error("Failed to create pipeline layout: {}", vk::to_string(res.error()));
+      return false;
+    }
+    m_layout = std::make_shared<vk::raii::PipelineLayout>(std::move(res.value()));
+    
+    return true;
+  }
+  
+  std::shared_ptr<VulkanPipeline> VulkanPipelineRegistry::acquire(const VulkanPplConfig& config) {
+    
+    // shared with every other pipeline built from the same file, the cache is not for the workers to touch.
+    // looked up first so the key knows which contents the file has now
+    uint64_t shaderHash = 0;
+    const vk::raii::ShaderModule* shaderModule = m_shaders->acquire(config.shaderPath, &shaderHash);
+    if(!shaderModule) {
+      Logger::error("Failed to create pipeline for material");
+      return nullptr;
+    }
+    
+    VulkanPplKey key{
+      .config = config,
+      .colorFormat = m_sc->getFormat(),
+      .depthFormat = m_depthFormat,
+      .shaderHash = shaderHash
+    };
+    
+    auto it = m_pipelines.find(key);
+    if(it != m_pipelines.end()) {
+      ++m_hits;
+      return it->second;
+    }
+    
+    ++m_misses;
+    auto pipeline = std::make_shared<VulkanPipeline>();
+    if(!pipeline->init(*shaderModule, m_layout, key)) {
+      Logger::error("Failed to create pipeline for material");
+      return nullptr;
+    }
+    
+    m_pipelines.emplace(key, pipeline);
+    m_queued.push_back(pipeline);
+    return pipeline;
+  }
+  
+  void VulkanPipelineRegistry::flush() {
+    if(m_queued.empty()) return;
+    
+    std::vector<std::shared_ptr<VulkanPipeline>> batch = std::move(m_queued);
+    m_queued.clear();
+    
+    auto job = m_workers->add_task([this, batch] { build(batch); });
+    if(!job.valid()) {
+      // the pool is shutting down
+      build(batch);
+      return;
+    }
+    m_jobs.push_back(std::move(job));
+  }
+  
+  void VulkanPipelineRegistry::prewarm(std::span<const VulkanPplConfig> configs) {
+    for(const auto& config : configs) acquire(config);
+    flush();
+  }
+  
+  void VulkanPipelineRegistry::collect() {
+    std::erase_if(m_jobs, [](const auto& job) { return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+  }
+  
+  void VulkanPipelineRegistry::wait() {
+    for(auto& job : m_jobs) job.wait();
+    m_jobs.clear();
+  }
+  
+  void VulkanPipelineRegistry::build(const std::vector<std::shared_ptr<VulkanPipeline>>& batch) const {
+    
+    std::vector<vk::GraphicsPipelineCreateInfo> infos;
+    infos.reserve(batch.size());
+    for(const auto& pipeline : batch) infos.push_back(pipeline->getCreateInfo());
+    
+    auto start = std::chrono::steady_clock::now();
+    auto res = m_lDev->createGraphicsPipelines(m_pplCache->getCache(), infos);
+    if(res) {
+      for(size_t i = 0; i < batch.size(); ++i) batch[i]->setPipeline(std::move(res.value()[i]));
+    } else {
+      Logger::warn("Batch of {} pipelines failed: {}, creating them one by one", batch.size(), vk::to_string(res.error()));
+      for(size_t i = 0; i < batch.size(); ++i) {
+        auto single = m_lDev->createGraphicsPipeline(m_pplCache->getCache(), infos[i]);
+        if(!single) {
+          Logger::error("Failed to create graphics pipeline: {}", vk::to_string(single.error()));
+          batch[i]->setFailed();
+          continue;
+        }
+        batch[i]->setPipeline(std::move(single.value()));
+      }
+    }
+    
+    auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Logger::info("{} pipelines created in {:.2f} ms ({} cache)", batch.size(), ms, m_pplCache->isWarm() ? "warm" : "cold");
+  }
+  
+  void VulkanPipelineRegistry::logStats() const {
+    Logger::info("Pipeline registry: {} pipelines, {} hits / {} misses", m_pipelines.size(), m_hits, m_misses);
+  }
+  
+}; //V
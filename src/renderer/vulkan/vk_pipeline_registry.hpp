@@ -0,0 +1,73 @@
+#pragma once
+
+#include "vk_pipeline.hpp"
+#include "../../tools/threadPool/threadpool.hpp"
+
+#include <unordered_map>
+
+namespace V {
+  
+  class VulkanSwapchain;
+  
+  // one pipeline per distinct VulkanPplKey for the lifetime of the device, every pipeline shares one layout
+  // built from the renderer's descriptor set layouts. Misses compile on the workers, batched per flush()
+  class VulkanPipelineRegistry {
+  public:
+    
+    VulkanPipelineRegistry();
+    ~VulkanPipelineRegistry();
+    
+    VulkanPipelineRegistry(const VulkanPipelineRegistry&) = delete;
+    VulkanPipelineRegistry& operator=(const VulkanPipelineRegistry&) = delete;
+    
+    bool init(
+      vk::raii::PhysicalDevice& pDev,
+      vk::raii::Device& lDev,
+      VulkanSwapchain& sc,
+      VulkanShaderCache& shaders,
+      VulkanPipelineCache& pplCache,
+      ThreadPool& workers,
+      std::span<const vk::DescriptorSetLayout> setLayouts
+    );
+    
+    // keyed by the config, the shader's current contents and the swapchain and depth formats; a miss returns a pipeline that is
+    // still compiling (see VulkanPipeline::isReady) and joins the next flush(). nullptr if the shader is missing
+    std::shared_ptr<VulkanPipeline> acquire(const VulkanPplConfig& config);
+    // hands every miss since the last flush to a worker as one vkCreateGraphicsPipelines call
+    void flush();
+    // acquire() and flush() for everything a scene is going to draw, ahead of its materials
+    void prewarm(std::span<const VulkanPplConfig> configs);
+    
+    // once per frame, forgets finished batches
+    void collect();
+    // blocks until every batch is built, before the pipeline cache is saved
+    void wait();
+    
+    vk::raii::PipelineLayout& getPipLayout() { return *m_layout; }
+    
+    uint32_t getHits() const { return m_hits; }
+    uint32_t getMisses() const { return m_misses; }
+    void logStats() const;
+  
+  private:
+    
+    // worker side; a failed batch is retried one by one so a single bad pipeline does not take the others with it
+    void build(const std::vector<std::shared_ptr<VulkanPipeline>>& batch) const;
+    
+    vk::raii::Device* m_lDev{nullptr};
+    VulkanSwapchain* m_sc{nullptr};
+    VulkanShaderCache* m_shaders{nullptr};
+    VulkanPipelineCache* m_pplCache{nullptr};
+    ThreadPool* m_workers{nullptr};
+    vk::Format m_depthFormat{vk::Format::eUndefined};
+    
+    std::shared_ptr<vk::raii::PipelineLayout> m_layout;
+    std::unordered_map<VulkanPplKey, std::shared_ptr<VulkanPipeline>, VulkanPplKeyHash> m_pipelines;
+    std::vector<std::shared_ptr<VulkanPipeline>> m_queued;
+    std::vector<std::future<void>> m_jobs;
+    uint32_t m_hits{0};
+    uint32_t m_misses{0};
+    
+  };
+  
+}; //V
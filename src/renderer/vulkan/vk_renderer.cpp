@@ -63,9 +63,7 @@ namespace V {
     m_cmdBufs[m_curFrame].begin({});
     
     transitionImageLayout(
-      m_logDev,
-      m_cmdPool,
-      m_graphQ,
+      m_cmdBufs[m_curFrame],
       m_sc.getImgs()[index],
       vk::ImageLayout::eUndefined,
       vk::ImageLayout::eColorAttachmentOptimal,
@@ -133,18 +131,21 @@ namespace V {
     m_cmdBufs[m_curFrame].setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), m_sc.getExtent()));
     
     // m_cmdBufs[m_curFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline.getPipeline());
-    m_cmdBufs[m_curFrame].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_model->getPipLayout(), 0, *(m_perFrameDescSets[m_curFrame]), nullptr);
-    
-    m_model->draw(m_cmdBufs[m_curFrame]);
+    // nothing to draw until the model is on the GPU, the frame is just cleared
+    if(m_model->isReady()) {
+      m_cmdBufs[m_curFrame].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelines.getPipLayout(), 0, *m_perFrameDescSet, m_uniformOffsets);
+      
+      // pool buffers are rebound only when the layout or index type of the next mesh changes
+      GeometryBindState geomState;
+      m_model->draw(m_cmdBufs[m_curFrame], geomState);
+    }
     // m_mesh.bind(m_cmdBufs[m_curFrame]);
     // m_cmdBufs[m_curFrame].drawIndexed(m_mesh.getIndexCount(), 1, 0, 0, 0);
     
     m_cmdBufs[m_curFrame].endRendering();
     
     transitionImageLayout(
-      m_logDev,
-      m_cmdPool,
-      m_graphQ,
+      m_cmdBufs[m_curFrame],
       m_sc.getImgs()[index],
       vk::ImageLayout::eColorAttachmentOptimal,
       vk::ImageLayout::ePresentSrcKHR,
@@ -188,6 +189,28 @@ namespace V {
     }
     m_imagesInFlight[imgIndex] = *m_inFlightFences[m_curFrame];
     
+    m_uploader.collect();
+    m_deletion.beginFrame(m_frameNumber);
+    m_budget.update(m_frameNumber);
+    m_pipelines.collect();
+    
+    // builds the model once its background import is done, the mesh upload joins this frame's batch
+    if(!m_model->poll()) {
+      Logger::error("Failed to load model");
+    }
+    float progress = m_model->getLoadProgress();
+    if(progress != m_modelProgress) {
+      m_modelProgress = progress;
+      Logger::info("Model loading: {:.0f}%", progress * 100.f);
+      if(progress == 1.f) {
+        m_geometry.logStats();
+        m_textures.logStats();
+        m_shaders.logStats();
+        m_pipelines.logStats();
+        m_allocator.logStats();
+      }
+    }
+    
     auto curTime = std::chrono::high_resolution_clock::now();
     float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(curTime - m_lastFrameTime).count();
     m_lastFrameTime = curTime;
@@ -197,11 +220,7 @@ namespace V {
     }
     
     // MATRICES==================================================
-    ObjectData objData{};
-    // objData.model = glm::rotate(glm::mat4(1.f), deltaTime * glm::radians(30.f), glm::vec3(0.f, 0.f, 1.f));
-    objData.model = glm::mat4(1.f);
-    objData.model *= m_model->getNormMatrix();
-    m_objectUBO.update(objData, m_curFrame);
+    m_uniforms.beginFrame(m_curFrame);
     
     CameraData camData{};
     glm::vec3 eyePos = glm::vec3(0.f, 2.f, 5.f);
@@ -210,20 +229,36 @@ namespace V {
     camData.view = glm::lookAt(eyePos, center, upV);
     camData.proj = glm::perspective(glm::radians(45.f), static_cast<float>(m_sc.getExtent().width) / static_cast<float>(m_sc.getExtent().height), 0.1f, 10.f);
     camData.proj[1][1] *= -1; // reverse
-    m_cameraUBO.update(camData, m_curFrame);
+    
+    ObjectData objData{};
+    // objData.model = glm::rotate(glm::mat4(1.f), deltaTime * glm::radians(30.f), glm::vec3(0.f, 0.f, 1.f));
+    objData.model = glm::mat4(1.f);
+    objData.model *= m_model->getNormMatrix();
+    
+    // next texture levels ride in the same batch as the frame, biggest on screen first
+    m_model->requestTextureSizes(camData.proj * camData.view * objData.model, m_sc.getExtent());
+    m_textures.stream(TEXTURE_STREAM_FRAME_BUDGET);
     
     BoneData boneData{};
     if(m_model->hasAnims()) {
       const auto& boneTransform = m_model->getBoneTransforms();
       if(!boneTransform.empty()) memcpy(boneData.bones, boneTransform.data(), boneTransform.size() * sizeof(glm::mat4));
     }
-    m_bonesUBO.update(boneData, m_curFrame);
+    
+    auto camOff = m_uniforms.push(camData);
+    auto objOff = m_uniforms.push(objData);
+    auto boneOff = m_uniforms.push(boneData);
+    if(!camOff || !objOff || !boneOff) return false;
+    m_uniformOffsets = {*camOff, *objOff, *boneOff};
     // MATRICES==================================================
     
     m_logDev.resetFences(*m_inFlightFences[m_curFrame]);
     m_cmdBufs[m_curFrame].reset();
     recordCmdBuf(imgIndex);
     
+    // uploads recorded since the last frame go out ahead of it, so nothing queued for deletion waits on an open batch
+    m_uploader.flush();
+    
     vk::PipelineStageFlags waitDestStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
     const vk::SubmitInfo submitInfo{
       .waitSemaphoreCount = 1,
@@ -254,6 +289,7 @@ namespace V {
     }
     
     m_curFrame = (m_curFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    ++m_frameNumber;
     
     return true;
     
@@ -310,9 +346,18 @@ namespace V {
         || !createSurf(wnd)
         || !pickPhysDev()
         || !createLogDev()
+        || !createAllocator()
+        || !createUploader()
+        || !createDeletionQueue()
+        || !createGeometry()
+        || !createBudget()
+        || !createTextureCache()
+        || !createShaderCache()
+        || !createPipelineCache()
         || !createSwapchain(wnd)
         || !createImgViews()
         || !createDescSetLayouts()
+        || !createPipelineRegistry()
         || !createCmdPool()
         
         || !createUBO()
@@ -516,15 +561,19 @@ namespace V {
     vk::StructureChain<
       vk::PhysicalDeviceFeatures2,
       vk::PhysicalDeviceVulkan11Features,
+      vk::PhysicalDeviceVulkan12Features,
       vk::PhysicalDeviceVulkan13Features,
       vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT
     > featureChain = {
       {
         .features{
-          .samplerAnisotropy = true
+          .samplerAnisotropy = true,
+          // cooked .ktx2 textures, VulkanTexture falls back to the source image without it
+          .textureCompressionBC = m_physDev.getFeatures().textureCompressionBC
         }
       },
       {.shaderDrawParameters = true},
+      {.timelineSemaphore = true},
       {
         .synchronization2 = true,
         .dynamicRendering = true
@@ -545,12 +594,22 @@ namespace V {
       );
     };
     
+    // optional: without it the allocator estimates the budget from its own allocations
+    std::vector<const char*> extensions = m_devExtensions;
+    auto availExts = m_physDev.enumerateDeviceExtensionProperties();
+    m_hasMemBudget = std::ranges::any_of(availExts, [](const auto& ext) {
+      return strcmp(ext.extensionName, vk::EXTMemoryBudgetExtensionName) == 0;
+    });
+    if(m_hasMemBudget) {
+      extensions.push_back(vk::EXTMemoryBudgetExtensionName);
+    }
+    
     vk::DeviceCreateInfo createInfo{
       .pNext = &featureChain.get<vk::PhysicalDeviceFeatures2>(),
       .queueCreateInfoCount = static_cast<uint32_t>(qCreateInfos.size()),
       .pQueueCreateInfos = qCreateInfos.data(),
-      .enabledExtensionCount = static_cast<uint32_t>(m_devExtensions.size()),
-      .ppEnabledExtensionNames = m_devExtensions.data()
+      .enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
+      .ppEnabledExtensionNames = extensions.data()
     };
     
     {
@@ -583,6 +642,88 @@ namespace V {
     return true;
   }
   
+  bool VulkanRenderer::createAllocator() {
+    
+    if(!m_allocator.init(m_inst, m_physDev, m_logDev, m_hasMemBudget)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createUploader() {
+    
+    if(!m_uploader.init(m_logDev, m_graphQ, m_graphQI, m_allocator)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createDeletionQueue() {
+    
+    if(!m_deletion.init(m_uploader)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createGeometry() {
+    
+    if(!m_geometry.init(m_allocator, m_logDev, m_uploader, m_deletion)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createBudget() {
+    
+    if(!m_budget.init(m_allocator, m_uploader, m_deletion, m_logDev)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createTextureCache() {
+    
+    if(!m_textures.init(m_physDev, m_logDev, m_allocator, m_uploader, m_deletion, m_budget, m_workers)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createShaderCache() {
+    
+    if(!m_shaders.init(m_logDev)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createPipelineCache() {
+    
+    if(!m_pplCache.init(m_physDev, m_logDev, PIPELINE_CACHE_PATH)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
+  bool VulkanRenderer::createPipelineRegistry() {
+    
+    std::array<vk::DescriptorSetLayout, 2> setLayouts = {*m_perFrameDescSetLayout, *m_perMatDescSetLayout};
+    if(!m_pipelines.init(m_physDev, m_logDev, m_sc, m_shaders, m_pplCache, m_workers, setLayouts)) {
+      return false;
+    }
+    
+    return true;
+  }
+  
   bool VulkanRenderer::createSurf(Window& wnd) {
     VkSurfaceKHR surf;
     if(glfwCreateWindowSurface(*m_inst, wnd.getWindow(), nullptr, &surf) != 0) {
@@ -626,7 +767,7 @@ namespace V {
       // binding 0: camera ubo
       vk::DescriptorSetLayoutBinding{
         .binding = 0,
-        .descriptorType = vk::DescriptorType::eUniformBuffer,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
         .descriptorCount = 1,
         .stageFlags = vk::ShaderStageFlagBits::eVertex,
         .pImmutableSamplers = nullptr
@@ -634,7 +775,7 @@ namespace V {
       // binding 2: object ubo
       vk::DescriptorSetLayoutBinding{
         .binding = 2,
-        .descriptorType = vk::DescriptorType::eUniformBuffer,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
         .descriptorCount = 1,
         .stageFlags = vk::ShaderStageFlagBits::eVertex,
         .pImmutableSamplers = nullptr
@@ -642,7 +783,7 @@ namespace V {
       // binding 3: bones ubo
       vk::DescriptorSetLayoutBinding{
         .binding = 3,
-        .descriptorType = vk::DescriptorType::eUniformBuffer,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
         .descriptorCount = 1,
         .stageFlags = vk::ShaderStageFlagBits::eVertex,
         .pImmutableSamplers = nullptr
@@ -712,16 +853,8 @@ namespace V {
   
   bool VulkanRenderer::createUBO() {
     
-    if(!m_cameraUBO.init(m_physDev, m_logDev)) {
-      Logger::error("Failed to init camera ubo");
-      return false;
-    }
-    if(!m_objectUBO.init(m_physDev, m_logDev)) {
-      Logger::error("Failed to init camera ubo");
-      return false;
-    }
-    if(!m_bonesUBO.init(m_physDev, m_logDev)) {
-      Logger::error("Failed to init camera ubo");
+    if(!m_uniforms.init(m_allocator, m_physDev, m_logDev)) {
+      Logger::error("Failed to init uniform ring");
       return false;
     }
     
@@ -741,8 +874,8 @@ namespace V {
           vk::ImageUsageFlagBits::eDepthStencilAttachment,
           vk::MemoryPropertyFlagBits::eDeviceLocal,
           m_depthImg,
-          m_depthImgMem,
-          m_physDev,
+          m_depthImgAlloc,
+          m_allocator,
           m_logDev
         )
     ) return false;
@@ -755,18 +888,18 @@ namespace V {
     
     std::array<vk::DescriptorPoolSize, 2> poolSize = {
       vk::DescriptorPoolSize{
-        .type = vk::DescriptorType::eUniformBuffer,
-        .descriptorCount = 3 * MAX_FRAMES_IN_FLIGHT // now three ubos per frame
+        .type = vk::DescriptorType::eUniformBufferDynamic,
+        .descriptorCount = 3 // three ubos, all frames share the set
       },
       vk::DescriptorPoolSize{
         .type = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = 100
+        .descriptorCount = MAX_MATERIALS * MATERIAL_DESC_SETS
       }
     };
     
     vk::DescriptorPoolCreateInfo poolInfo{
       .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-      .maxSets = 100 + MAX_FRAMES_IN_FLIGHT,
+      .maxSets = MAX_MATERIALS * MATERIAL_DESC_SETS + 1, // material rings + the shared set=0
       .poolSizeCount = poolSize.size(),
       .pPoolSizes = poolSize.data()
     };
@@ -789,15 +922,19 @@ namespace V {
       false,
       m_physDev,
       m_logDev,
-      m_sc,
-      m_cmdPool,
-      m_graphQ,
-      m_perFrameDescSetLayout,
+      m_allocator,
+      m_uploader,
+      m_geometry,
+      m_textures,
+      m_pipelines,
+      m_deletion,
+      m_workers,
       m_perMatDescSetLayout,
       m_descPool
     );
     
-    if(!m_model->load("../../assets/models/chest/source/MESH_Chest.fbx")) {
+    // the window presents right away, the model shows up once it is imported and uploaded
+    if(!m_model->loadAsync("../../assets/models/chest/source/MESH_Chest.fbx")) {
       Logger::error("Failed to load model");
       return false;
     }
@@ -807,74 +944,70 @@ namespace V {
   
   bool VulkanRenderer::createDescSets() {
     
-    std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, *(m_perFrameDescSetLayout));
     vk::DescriptorSetAllocateInfo allocInfo{
       .descriptorPool = m_descPool,
-      .descriptorSetCount = static_cast<uint32_t>(layouts.size()),
-      .pSetLayouts = layouts.data()
+      .descriptorSetCount = 1,
+      .pSetLayouts = &*m_perFrameDescSetLayout
     };
     
-    m_perFrameDescSets.clear();
     {
       auto res = m_logDev.allocateDescriptorSets(allocInfo);
       if(!res) {
         Logger::error("Failed to allocate descriptor sets: {}", vk::to_string(res.error()));
         return false;
       }
-      m_perFrameDescSets = std::move(res.value());
-    }
-
-    for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-      vk::DescriptorBufferInfo cameraBufInfo{ // binding 0
-        .buffer = m_cameraUBO.getUBufs()[i],
-        .offset = 0,
-        .range = sizeof(CameraData)
-      };
-      vk::DescriptorBufferInfo objectBufInfo{ // binding 2
-        .buffer = m_objectUBO.getUBufs()[i],
-        .offset = 0,
-        .range = sizeof(ObjectData)
-      };
-      vk::DescriptorBufferInfo bonesBufInfo{ // binding 3
-        .buffer = m_bonesUBO.getUBufs()[i],
-        .offset = 0,
-        .range = sizeof(BoneData)
-      };
-      
-      
-      std::array<vk::WriteDescriptorSet, 3> descWrites = {
-        vk::WriteDescriptorSet {
-          .dstSet = m_perFrameDescSets[i],
-          .dstBinding = 0, // binding 0
-          .dstArrayElement = 0,
-          .descriptorCount = 1,
-          .descriptorType = vk::DescriptorType::eUniformBuffer,
-          .pImageInfo = nullptr,
-          .pBufferInfo = &cameraBufInfo
-        },
-        vk::WriteDescriptorSet {
-          .dstSet = m_perFrameDescSets[i],
-          .dstBinding = 2, // binding 2
-          .dstArrayElement = 0,
-          .descriptorCount = 1,
-          .descriptorType = vk::DescriptorType::eUniformBuffer,
-          .pImageInfo = nullptr,
-          .pBufferInfo = &objectBufInfo
-        },
-        vk::WriteDescriptorSet {
-          .dstSet = m_perFrameDescSets[i],
-          .dstBinding = 3, // binding 3
-          .dstArrayElement = 0,
-          .descriptorCount = 1,
-          .descriptorType = vk::DescriptorType::eUniformBuffer,
-          .pImageInfo = nullptr,
-          .pBufferInfo = &bonesBufInfo
-        }
-      };
-      
-      m_logDev.updateDescriptorSets(descWrites, {});
+      m_perFrameDescSet = std::move(res.value().front());
     }
     
+    // offsets are 0 here, the slice of every draw comes from the dynamic offsets
+    vk::DescriptorBufferInfo cameraBufInfo{ // binding 0
+      .buffer = m_uniforms.getBuf(),
+      .offset = 0,
+      .range = sizeof(CameraData)
+    };
+    vk::DescriptorBufferInfo objectBufInfo{ // binding 2
+      .buffer = m_uniforms.getBuf(),
+      .offset = 0,
+      .range = sizeof(ObjectData)
+    };
+    vk::DescriptorBufferInfo bonesBufInfo{ // binding 3
+      .buffer = m_uniforms.getBuf(),
+      .offset = 0,
+      .range = sizeof(BoneData)
+    };
+    
+    std::array<vk::WriteDescriptorSet, 3> descWrites = {
+      vk::WriteDescriptorSet {
+        .dstSet = m_perFrameDescSet,
+        .dstBinding = 0, // binding 0
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+        .pImageInfo = nullptr,
+        .pBufferInfo = &cameraBufInfo
+      },
+      vk::WriteDescriptorSet {
+        .dstSet = m_perFrameDescSet,
+        .dstBinding = 2, // binding 2
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+        .pImageInfo = nullptr,
+        .pBufferInfo = &objectBufInfo
+      },
+      vk::WriteDescriptorSet {
+        .dstSet = m_perFrameDescSet,
+        .dstBinding = 3, // binding 3
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+        .pImageInfo = nullptr,
+        .pBufferInfo = &bonesBufInfo
+      }
+    };
+    
+    m_logDev.updateDescriptorSets(descWrites, {});
+    
     return true;
   }
   
@@ -942,6 +1075,17 @@ namespace V {
   
   void VulkanRenderer::cleanup() {
     
+    if(!*m_logDev) return;
+    m_logDev.waitIdle();
+    
+    // whatever the driver compiled this run is there for the next one
+    m_pipelines.wait();
+    m_pplCache.save();
+    
+    // retired descriptor sets must go back before the pool is destroyed
+    m_deletion.flush();
+    m_uploader.wait(m_uploader.flush());
+    m_uploader.collect();
   }
   
 }; //V
\ No newline at end of file
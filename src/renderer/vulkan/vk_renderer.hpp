@@ -54,10 +54,19 @@ namespace V {
     bool setupDM();
     bool pickPhysDev();
     bool createLogDev();
+    bool createAllocator();
+    bool createUploader();
+    bool createDeletionQueue();
+    bool createGeometry();
+    bool createBudget();
+    bool createTextureCache();
+    bool createShaderCache();
+    bool createPipelineCache();
     bool createSurf(Window& wnd);
     bool createSwapchain(Window& wnd);
     bool createImgViews();
     bool createDescSetLayouts();
+    bool createPipelineRegistry();
     bool createCmdPool();
     
     bool createUBO();
@@ -94,6 +103,14 @@ namespace V {
     vk::raii::DebugUtilsMessengerEXT m_debMesser{nullptr};
     vk::raii::PhysicalDevice m_physDev{nullptr};
     vk::raii::Device m_logDev{nullptr};
+    VulkanAllocator m_allocator;
+    VulkanUploader m_uploader;
+    VulkanDeletionQueue m_deletion;
+    VulkanGeometryPool m_geometry;
+    VulkanMemoryBudget m_budget;
+    VulkanTextureCache m_textures;
+    VulkanShaderCache m_shaders;
+    VulkanPipelineCache m_pplCache;
     vk::raii::Queue m_graphQ{nullptr};
     vk::raii::Queue m_presQ{nullptr};
     vk::raii::SurfaceKHR m_surf{nullptr};
@@ -102,9 +119,10 @@ namespace V {
     vk::raii::DescriptorSetLayout m_perFrameDescSetLayout{nullptr};
     vk::raii::DescriptorSetLayout m_perMatDescSetLayout{nullptr};
     vk::raii::DescriptorPool m_descPool{nullptr};
+    VulkanPipelineRegistry m_pipelines; // after the set layouts its pipeline layout is built from
     
     vk::raii::Image m_depthImg{nullptr};
-    vk::raii::DeviceMemory m_depthImgMem{nullptr};
+    VulkanAllocation m_depthImgAlloc{nullptr};
     vk::raii::ImageView m_depthImgView{nullptr};
     
     std::vector<vk::raii::CommandBuffer> m_cmdBufs;
@@ -112,13 +130,15 @@ namespace V {
     std::vector<vk::raii::Semaphore> m_renderFinishedSems;
     std::vector<vk::raii::Fence> m_inFlightFences;
     std::vector<vk::Fence> m_imagesInFlight;
-    std::vector<vk::raii::DescriptorSet> m_perFrameDescSets;
+    vk::raii::DescriptorSet m_perFrameDescSet{nullptr}; // frames differ only by dynamic offsets
     
+    // CPU side of asset loading, one thread is left to the main loop
+    ThreadPool m_workers{std::max(std::thread::hardware_concurrency(), 2u) - 1};
     std::unique_ptr<VulkanModel> m_model{nullptr};
+    float m_modelProgress{-1.f};
     
-    UBOManager<CameraData> m_cameraUBO;
-    UBOManager<ObjectData> m_objectUBO;
-    UBOManager<BoneData> m_bonesUBO;
+    VulkanUniformRing m_uniforms;
+    std::array<uint32_t, 3> m_uniformOffsets{}; // camera, object, bones - binding order of set=0
     
     VulkanSwapchain m_sc;
     
@@ -129,6 +149,8 @@ namespace V {
     Window* m_wnd;
     
     size_t m_curFrame = 0;
+    uint64_t m_frameNumber = 0;
+    bool m_hasMemBudget = false; // VK_EXT_memory_budget enabled on the device
     uint32_t m_graphQI;
     uint32_t m_presQI;
     
@@ -0,0 +1,85 @@
+#include "vk_shader_cache.hpp"
+#include "../../tools/mappedFile/mapped_file.hpp"
+
+namespace V {
+  
+  VulkanShaderCache::VulkanShaderCache() {
+    
+  }
+  
+  VulkanShaderCache::~VulkanShaderCache() {
+    
+  }
+  
+  bool VulkanShaderCache::init(vk::raii::Device& lDev) {
+    
+    m_lDev = &lDev;
+    
+    return true;
+  }
+  
+  const vk::raii::ShaderModule* VulkanShaderCache::acquire(std::string_view path, uint64_t* hash) {
+    
+    std::error_code ec;
+    std::string key = std::filesystem::weakly_canonical(path, ec).string();
+    if(ec) key = std::filesystem::path(path).lexically_normal().string();
+    
+    auto mtime = std::filesystem::last_write_time(key, ec);
+    if(ec) {
+      Logger::error("Failed to open file: {}", path);
+      return nullptr;
+    }
+    
+    // unchanged since the last read, no need to touch the contents
+    auto fileIt = m_files.find(key);
+    if(fileIt != m_files.end() && fileIt->second.mtime == mtime) {
+      auto it = m_modules.find(fileIt->second.hash);
+      if(it != m_modules.end()) {
+        ++m_hits;
+        if(hash) *hash = it->first;
+        return &it->second;
+      }
+    }
+    
+    MappedFile file;
+    if(!file.open(key)) {
+      Logger::error("Failed to open file: {}", path);
+      return nullptr;
+    }
+    ++m_reads;
+    
+    // the mapping is page aligned, only the size can be off
+    if(file.size() % sizeof(uint32_t) != 0) {
+      Logger::error("{} is not SPIR-V: size {} is not a multiple of 4", path, file.size());
+      return nullptr;
+    }
+    
+    uint64_t contentHash = hashBytes(file.bytes());
+    m_files[key] = FileEntry{.mtime = mtime, .hash = contentHash};
+    if(hash) *hash = contentHash;
+    
+    auto it = m_modules.find(contentHash);
+    if(it != m_modules.end()) {
+      ++m_hits;
+      return &it->second;
+    }
+    
+    vk::ShaderModuleCreateInfo createInfo{
+      .codeSize = file.size(),
+      .pCode = reinterpret_cast<const uint32_t*>(file.data())
+    };
+    
+    auto res = m_lDev->createShaderModule(createInfo);
+    if(!res) {
+      Logger::error("Failed to create shader module: {}", vk::to_string(res.error()));
+      return nullptr;
+    }
+    
+    return &m_modules.emplace(contentHash, std::move(res.value())).first->second;
+  }
+  
+  void VulkanShaderCache::logStats() const {
+    Logger::info("Shader cache: {} modules from {} files, {} reads / {} hits", m_modules.size(), m_files.size(), m_reads, m_hits);
+  }
+  
+}; //V
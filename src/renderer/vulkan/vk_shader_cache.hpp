@@ -0,0 +1,45 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+#include <filesystem>
+#include <unordered_map>
+
+namespace V {
+  
+  // SPIR-V modules for the lifetime of the device: a file is mapped and hashed once per change on disk,
+  // files with the same content share one module
+  class VulkanShaderCache {
+  public:
+    
+    VulkanShaderCache();
+    ~VulkanShaderCache();
+    
+    VulkanShaderCache(const VulkanShaderCache&) = delete;
+    VulkanShaderCache& operator=(const VulkanShaderCache&) = delete;
+    
+    bool init(vk::raii::Device& lDev);
+    
+    // nullptr if the file is missing or not SPIR-V; the module stays valid until the cache goes away,
+    // pipelines do not need to keep it after creation. hash receives the content hash the module was built from
+    const vk::raii::ShaderModule* acquire(std::string_view path, uint64_t* hash = nullptr);
+    
+    void logStats() const;
+  
+  private:
+    
+    struct FileEntry {
+      std::filesystem::file_time_type mtime;
+      uint64_t hash;
+    };
+    
+    vk::raii::Device* m_lDev{nullptr};
+    
+    std::unordered_map<std::string, FileEntry> m_files; // canonical path -> content it had last time
+    std::unordered_map<uint64_t, vk::raii::ShaderModule> m_modules; // content hash -> module
+    uint32_t m_hits{0};
+    uint32_t m_reads{0};
+    
+  };
+  
+}; //V
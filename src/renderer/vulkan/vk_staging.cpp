@@ -0,0 +1,104 @@
+#include "vk_staging.hpp"
+
+namespace V {
+  
+  VulkanStagingRing::VulkanStagingRing() {
+    
+  }
+  
+  VulkanStagingRing::~VulkanStagingRing() {
+    
+  }
+  
+  bool VulkanStagingRing::init(VulkanAllocator& allocator, vk::raii::Device& lDev, vk::DeviceSize size) {
+    
+    if(!createBuf(
+      size,
+      vk::BufferUsageFlagBits::eTransferSrc,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+      m_buf,
+      m_alloc,
+      allocator,
+      lDev,
+      VMA_ALLOCATION_CREATE_MAPPED_BIT
+    )) {
+      Logger::error("Failed to create staging ring");
+      return false;
+    }
+    
+    m_mapped = static_cast<std::byte*>(m_alloc.getMapped());
+    m_size = size;
+    
+    Logger::info("Staging ring: {:.2f} MB", static_cast<float>(size) / (1024.f * 1024.f));
+    return true;
+  }
+  
+  std::optional<StagingSlice> VulkanStagingRing::alloc(vk::DeviceSize size, vk::DeviceSize align) {
+    
+    if(size == 0 || size > m_size) return std::nullopt;
+    
+    if(m_regions.empty()) {
+      m_head = 0;
+    }
+    
+    auto alignUp = [align](vk::DeviceSize v) { return (v + align - 1) / align * align; };
+    
+    vk::DeviceSize begin = alignUp(m_head);
+    if(m_regions.empty()) {
+      begin = 0;
+    }
+    else {
+      vk::DeviceSize tail = m_regions.front().begin;
+      if(m_head > tail) {
+        // free space is [head, size) and [0, tail)
+        if(begin + size > m_size) {
+          if(size > tail) return std::nullopt;
+          begin = 0;
+        }
+      }
+      else {
+        // wrapped: free space is [head, tail)
+        if(begin + size > tail) return std::nullopt;
+      }
+    }
+    
+    Region region{
+      .id = m_nextId++,
+      .begin = begin,
+      .end = begin + size,
+      .ticket = 0
+    };
+    m_regions.push_back(region);
+    m_head = region.end;
+    
+    return StagingSlice{
+      .id = region.id,
+      .offset = region.begin,
+      .size = size,
+      .data = m_mapped + region.begin
+    };
+  }
+  
+  void VulkanStagingRing::retire(const StagingSlice& slice, uint64_t ticket) {
+    if(m_regions.empty() || slice.id < m_regions.front().id) return;
+    
+    size_t index = static_cast<size_t>(slice.id - m_regions.front().id);
+    if(index < m_regions.size()) {
+      m_regions[index].ticket = ticket;
+    }
+  }
+  
+  void VulkanStagingRing::reclaim(uint64_t completedTicket) {
+    while(!m_regions.empty() && m_regions.front().ticket != 0 && m_regions.front().ticket <= completedTicket) {
+      m_regions.pop_front();
+    }
+  }
+  
+  vk::DeviceSize VulkanStagingRing::getUsed() const {
+    if(m_regions.empty()) return 0;
+    
+    vk::DeviceSize tail = m_regions.front().begin;
+    return m_head > tail ? m_head - tail : m_size - tail + m_head;
+  }
+  
+}; //V
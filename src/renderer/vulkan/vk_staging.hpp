@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vk_buffer.hpp"
+
+namespace V {
+  
+  struct StagingSlice {
+    uint64_t id{0};
+    vk::DeviceSize offset{0};
+    vk::DeviceSize size{0};
+    void* data{nullptr};
+  };
+  
+  // one persistently mapped host buffer handed out front to back;
+  // a slice is reclaimed once the batch that copied from it has finished
+  class VulkanStagingRing {
+  public:
+    
+    VulkanStagingRing();
+    ~VulkanStagingRing();
+    
+    bool init(VulkanAllocator& allocator, vk::raii::Device& lDev, vk::DeviceSize size);
+    
+    std::optional<StagingSlice> alloc(vk::DeviceSize size, vk::DeviceSize align);
+    void retire(const StagingSlice& slice, uint64_t ticket);
+    void reclaim(uint64_t completedTicket);
+    
+    vk::raii::Buffer& getBuf() { return m_buf; }
+    vk::DeviceSize getSize() const { return m_size; }
+    vk::DeviceSize getUsed() const;
+  
+  private:
+    
+    struct Region {
+      uint64_t id;
+      vk::DeviceSize begin;
+      vk::DeviceSize end;
+      uint64_t ticket; // 0 while nothing has been recorded from it
+    };
+    
+    vk::raii::Buffer m_buf{nullptr};
+    VulkanAllocation m_alloc{nullptr};
+    std::byte* m_mapped{nullptr};
+    vk::DeviceSize m_size{0};
+    
+    std::deque<Region> m_regions;
+    vk::DeviceSize m_head{0};
+    uint64_t m_nextId{1};
+    
+  };
+  
+}; //V
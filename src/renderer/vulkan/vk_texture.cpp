@@ -2,6 +2,10 @@
 #include <stb_image.h>
 
 #include "vk_texture.hpp"
+#include "../../tools/mappedFile/mapped_file.hpp"
+
+#include <vulkan/vulkan_format_traits.hpp>
+#include <filesystem>
 
 namespace V {
   
@@ -9,78 +13,517 @@ namespace V {
     
   }
   VulkanTexture::~VulkanTexture() {
-    
+    // the worker writes into our staging memory
+    if(m_decode.valid()) m_decode.wait();
   }
   
   bool VulkanTexture::init(
     std::string& path,
     vk::raii::PhysicalDevice& pDev,
     vk::raii::Device& lDev,
-    vk::raii::CommandPool& cmdPool,
-    vk::raii::Queue& graphQ
+    VulkanAllocator& allocator,
+    VulkanUploader& uploader
   ) {
-    if(  !createTextureImg(path, pDev, lDev, cmdPool, graphQ)
-      || !createTextureImgView(lDev)
+    return load(path, pDev, lDev, allocator, nullptr) && finishLoad(uploader);
+  }
+  
+  bool VulkanTexture::initSolid(
+    uint32_t rgba,
+    vk::raii::PhysicalDevice& pDev,
+    vk::raii::Device& lDev,
+    VulkanAllocator& allocator,
+    VulkanUploader& uploader
+  ) {
+    
+    m_width = 1;
+    m_height = 1;
+    m_format = vk::Format::eR8G8B8A8Srgb;
+    m_mipLevels = 1;
+    
+    if(!createImage(
+      m_width,
+      m_height,
+      m_format,
+      vk::ImageTiling::eOptimal,
+      vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+      vk::MemoryPropertyFlagBits::eDeviceLocal,
+      m_texImg,
+      m_texImgAlloc,
+      allocator,
+      lDev,
+      m_mipLevels
+    )) return false;
+    
+    if(  !createTextureImgView(lDev)
       || !createTextureSampler(pDev, lDev)
+      || !uploader.transitionImage(m_texImg, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal)
+      || !uploader.uploadImg(&rgba, sizeof(rgba), m_texImg, m_width, m_height)
+      || !uploader.transitionImage(m_texImg, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal)
     ) return false;
     
-    s_path = path;
     return true;
   }
   
-  
-  bool VulkanTexture::createTextureImg(
-    std::string& path,
+  bool VulkanTexture::load(
+    const std::string& path,
     vk::raii::PhysicalDevice& pDev,
     vk::raii::Device& lDev,
-    vk::raii::CommandPool& cmdPool,
-    vk::raii::Queue& graphQ
+    VulkanAllocator& allocator,
+    ThreadPool* workers
   ) {
+    if(  !createTextureImg(path, pDev, lDev, allocator, workers != nullptr)
+      || !createTextureImgView(lDev)
+      || !createTextureSampler(pDev, lDev)
+    ) return false;
+    
+    s_path = path;
+    
+    if(workers) {
+      m_decode = workers->add_task([this]() { return decodeStaging(); });
+    }
+    
+    return true;
+  }
+  
+  bool VulkanTexture::finishLoad(VulkanUploader& uploader) {
+    
+    if(!*m_staging) return true;
+    
+    bool decoded = collectDecode();
+    return recordLoad(uploader) && decoded;
+  }
+  
+  bool VulkanTexture::recordLoad(VulkanUploader& uploader) {
+    
+    if(!uploader.transitionImage(m_texImg, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 0, m_mipLevels)) return false;
+    
+    if(m_stagedMips == m_mipLevels) {
+      for(uint32_t i = 0; i < m_mipLevels; ++i) {
+        if(!uploader.copyBufToImg(m_staging, m_texImg, getMipSize(m_width, i), getMipSize(m_height, i), getChainSize(m_format, m_width, m_height, i), i)) return false;
+      }
+      if(!uploader.transitionImage(m_texImg, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, 0, m_mipLevels)) return false;
+    } else {
+      if(!uploader.copyBufToImg(m_staging, m_texImg, m_width, m_height)) return false;
+      if(!uploader.generateMips(m_texImg, m_width, m_height, m_mipLevels)) return false;
+    }
+    
+    uploader.keepAlive(std::move(m_staging), std::move(m_stagingAlloc));
+    
+    return true;
+  }
+  
+  bool VulkanTexture::collectDecode() {
+    
+    // no pool, or the pool is shutting down: decode here
+    bool decoded = m_decode.valid() ? m_decode.get() : decodeStaging();
+    if(!decoded) {
+      // keep the image valid, a missing texture should be obvious but not fatal
+      vk::DeviceSize size = getChainSize(m_format, m_width, m_height, m_stagedMips);
+      if(m_format == vk::Format::eR8G8B8A8Srgb) {
+        auto* px = static_cast<uint32_t*>(m_stagingAlloc.getMapped());
+        std::fill(px, px + size / 4, 0xFFFF00FFu);
+      } else {
+        // zeroed blocks decode to black in every BC format used here
+        std::memset(m_stagingAlloc.getMapped(), 0, size);
+      }
+    }
+    
+    return decoded;
+  }
+  
+  bool VulkanTexture::beginStreaming(VulkanUploader& uploader, vk::raii::Device& lDev, VulkanDeletionQueue& deletion) {
+    
+    // already streaming for another model, or fully loaded
+    if(m_streaming || !*m_staging) return true;
+    // staged for a GPU-built chain, nothing small to start with
+    if(m_stagedMips != m_mipLevels) {
+      // a failed decode is a placeholder like everywhere else while streaming
+      collectDecode();
+      return recordLoad(uploader);
+    }
+    
+    m_streaming = true;
+    m_residentMip = m_mipLevels;
+    if(!uploader.transitionImage(m_texImg, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 0, m_mipLevels)) return false;
+    
+    bool pending = m_decode.valid() && m_decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    if(pending && m_format == vk::Format::eR8G8B8A8Srgb) {
+      // grey until the decode lands, so the texture can be sampled from the first frame on
+      uint32_t last = m_mipLevels - 1;
+      uint32_t w = getMipSize(m_width, last);
+      uint32_t h = getMipSize(m_height, last);
+      std::vector<uint32_t> grey(static_cast<size_t>(w) * h, 0xFF808080u);
+      if(  !uploader.uploadImg(grey.data(), grey.size() * sizeof(uint32_t), m_texImg, w, h, last)
+        || !uploader.transitionImage(m_texImg, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, last)
+      ) return false;
+      
+      m_placeholder = true;
+      return setResidentMip(last, lDev, deletion);
+    }
+    
+    // done already, or cooked levels that are a plain copy out of the file and not worth a placeholder
+    collectDecode();
+    
+    // at least the smallest level, whatever the budget
+    stream(uploader, lDev, deletion, 0);
+    return true;
+  }
+  
+  vk::DeviceSize VulkanTexture::stream(VulkanUploader& uploader, vk::raii::Device& lDev, VulkanDeletionQueue& deletion, vk::DeviceSize budget) {
+    
+    if(!isStreaming()) return 0;
+    if(m_decode.valid()) {
+      if(m_decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return 0;
+      collectDecode();
+    }
+    
+    uint32_t last = m_mipLevels - 1;
+    uint32_t wanted = getWantedMip();
+    // the grey texel is overwritten in place, the view does not change for it
+    uint32_t mip = m_placeholder ? m_mipLevels : m_residentMip;
+    vk::DeviceSize used = 0;
+    
+    while(mip > wanted) {
+      uint32_t next = mip - 1;
+      vk::DeviceSize offset = getChainSize(m_format, m_width, m_height, next);
+      vk::DeviceSize size = getChainSize(m_format, m_width, m_height, next + 1) - offset;
+      if(used > 0 && used + size > budget) break;
+      
+      if(next == last && m_placeholder) {
+        if(!uploader.transitionImage(m_texImg, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferDstOptimal, last)) return used;
+        m_placeholder = false;
+      }
+      if(!uploader.copyBufToImg(m_staging, m_texImg, getMipSize(m_width, next), getMipSize(m_height, next), offset, next)) return used;
+      if(!uploader.transitionImage(m_texImg, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, next)) return used;
+      
+      used += size;
+      mip = next;
+    }
+    
+    if(mip < m_residentMip && !setResidentMip(mip, lDev, deletion)) return used;
+    
+    if(m_residentMip == 0) {
+      // every level is on the GPU, the staging memory goes once this batch is done with it
+      uploader.keepAlive(std::move(m_staging), std::move(m_stagingAlloc));
+    }
+    
+    return used;
+  }
+  
+  void VulkanTexture::releaseIdleStaging(VulkanUploader& uploader) {
+    
+    if(!isStreaming() || m_placeholder || getWantedMip() < m_residentMip) {
+      m_idleFrames = 0;
+      return;
+    }
+    
+    if(++m_idleFrames >= TEXTURE_STAGING_IDLE_FRAMES && releaseStaging(uploader)) {
+      m_restage = true;
+    }
+  }
+  
+  bool VulkanTexture::restage(vk::raii::Device& lDev, VulkanAllocator& allocator, ThreadPool* workers) {
+    
+    if(!needsRestage()) return false;
+    m_restage = false;
+    
+    if(!createStaging(lDev, allocator)) {
+      Logger::error("Texture {} stays at level {}", s_path, m_residentMip);
+      return false;
+    }
+    
+    if(workers) m_decode = workers->add_task([this]() { return decodeStaging(); });
+    // no pool, or the pool is shutting down: decode here
+    if(!m_decode.valid()) collectDecode();
+    
+    return true;
+  }
+  
+  bool VulkanTexture::releaseStaging(VulkanUploader& uploader) {
+    
+    if(!isStreaming() || m_decode.valid()) return false;
+    
+    uploader.keepAlive(std::move(m_staging), std::move(m_stagingAlloc));
+    m_idleFrames = 0;
+    return true;
+  }
+  
+  uint32_t VulkanTexture::getWantedMip() const {
+    
+    uint32_t mip = m_mipLevels - 1;
+    if(m_requestedSize == 0) return mip;
+    
+    uint32_t size = std::max(m_width, m_height);
+    while(mip > 0 && getMipSize(size, mip) < m_requestedSize) --mip;
+    return mip;
+  }
+  
+  bool VulkanTexture::setResidentMip(uint32_t mip, vk::raii::Device& lDev, VulkanDeletionQueue& deletion) {
+    
+    vk::raii::ImageView view{nullptr};
+    if(!createImgView(*m_texImg, m_format, vk::ImageAspectFlagBits::eColor, view, lDev, m_mipLevels - mip, mip)) return false;
+    
+    // frames in flight may still sample through the old view
+    if(*m_texImgView) deletion.push(std::move(m_texImgView));
+    m_texImgView = std::move(view);
+    m_residentMip = mip;
+    ++m_version;
+    
+    return true;
+  }
+  
+  vk::DeviceSize VulkanTexture::getChainSize(vk::Format format, uint32_t w, uint32_t h, uint32_t mipLevels) {
+    auto extent = vk::blockExtent(format);
+    vk::DeviceSize size = 0;
+    for(uint32_t i = 0; i < mipLevels; ++i) {
+      vk::DeviceSize blocksX = (getMipSize(w, i) + extent[0] - 1) / extent[0];
+      vk::DeviceSize blocksY = (getMipSize(h, i) + extent[1] - 1) / extent[1];
+      size += blocksX * blocksY * vk::blockSize(format);
+    }
+    return size;
+  }
+  
+  bool VulkanTexture::decodeStaging() const {
+    if(!m_cookedPath.empty()) {
+      return decodeCooked(m_cookedPath, m_cooked, m_stagingAlloc.getMapped());
+    }
+    return decode(s_path, m_width, m_height, m_stagedMips, m_stagingAlloc.getMapped());
+  }
+  
+  bool VulkanTexture::decodeCooked(const std::string& path, const Ktx2Image& expected, void* dst) {
+    
+    MappedFile file;
+    Ktx2Image image;
+    if(!file.open(path) || !readKtx2(file.bytes(), image)) {
+      Logger::error("Failed to read cooked texture {}", path);
+      return false;
+    }
+    if(image.format != expected.format || image.width != expected.width || image.height != expected.height || image.levels.size() != expected.levels.size()) {
+      Logger::error("Texture {} changed while loading", path);
+      return false;
+    }
+    
+    // the file stores the smallest level first, staging wants level 0 first
+    auto* out = static_cast<std::byte*>(dst);
+    for(const auto& level : image.levels) {
+      std::memcpy(out, file.data() + level.byteOffset, level.byteLength);
+      out += level.byteLength;
+    }
+    
+    return true;
+  }
+  
+  // per-channel rounded average of four RGBA8 texels, all four channels at once in one register
+  static uint32_t average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    uint32_t hi = ((a >> 2) & 0x3F3F3F3Fu) + ((b >> 2) & 0x3F3F3F3Fu) + ((c >> 2) & 0x3F3F3F3Fu) + ((d >> 2) & 0x3F3F3F3Fu);
+    uint32_t lo = (a & 0x03030303u) + (b & 0x03030303u) + (c & 0x03030303u) + (d & 0x03030303u) + 0x02020202u;
+    return hi + ((lo >> 2) & 0x03030303u);
+  }
+  
+  void VulkanTexture::downsample(const uint32_t* src, uint32_t srcW, uint32_t srcH, uint32_t* dst) {
+    uint32_t w = std::max(srcW / 2, 1u);
+    uint32_t h = std::max(srcH / 2, 1u);
+    
+    // odd or 1-texel edges clamp, so the last row / column is averaged with itself
+    for(uint32_t y = 0; y < h; ++y) {
+      const uint32_t* row0 = src + static_cast<size_t>(std::min(y * 2, srcH - 1)) * srcW;
+      const uint32_t* row1 = src + static_cast<size_t>(std::min(y * 2 + 1, srcH - 1)) * srcW;
+      for(uint32_t x = 0; x < w; ++x) {
+        uint32_t x0 = std::min(x * 2, srcW - 1);
+        uint32_t x1 = std::min(x * 2 + 1, srcW - 1);
+        dst[static_cast<size_t>(y) * w + x] = average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+      }
+    }
+  }
+  
+  bool VulkanTexture::decode(const std::string& path, uint32_t w, uint32_t h, uint32_t mipLevels, void* dst) {
     
     int texWidth, texHeight, texChannels;
-    // Logger::debug("{}", path.data());
     stbi_uc* pixels = stbi_load(path.data(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    vk::DeviceSize imgSize = texWidth * texHeight * 4;
-    
     if(!pixels) {
-      Logger::error("Failed to load texture image");
+      Logger::error("Failed to load texture image {}", path);
+      return false;
+    }
+    
+    bool match = static_cast<uint32_t>(texWidth) == w && static_cast<uint32_t>(texHeight) == h;
+    if(!match) {
+      Logger::error("Texture {} changed while loading", path);
+      stbi_image_free(pixels);
+      return false;
+    }
+    memcpy(dst, pixels, static_cast<size_t>(w) * h * 4);
+    stbi_image_free(pixels);
+    
+    // each level is filtered from the previous one, already in staging
+    auto* base = static_cast<std::byte*>(dst);
+    for(uint32_t i = 1; i < mipLevels; ++i) {
+      downsample(
+        reinterpret_cast<const uint32_t*>(base + getChainSize(vk::Format::eR8G8B8A8Srgb, w, h, i - 1)),
+        getMipSize(w, i - 1),
+        getMipSize(h, i - 1),
+        reinterpret_cast<uint32_t*>(base + getChainSize(vk::Format::eR8G8B8A8Srgb, w, h, i))
+      );
+    }
+    
+    return true;
+  }
+  
+  bool VulkanTexture::openCooked(const std::string& path, vk::raii::PhysicalDevice& pDev) {
+    
+    std::filesystem::path source(path);
+    std::filesystem::path cooked = source;
+    cooked.replace_extension(".ktx2");
+    
+    std::error_code ec;
+    if(!std::filesystem::exists(cooked, ec)) return false;
+    if(cooked != source && std::filesystem::exists(source, ec)
+      && std::filesystem::last_write_time(source, ec) > std::filesystem::last_write_time(cooked, ec)
+    ) {
+      Logger::warn("Cooked texture {} is older than its source, loading the source", cooked.string());
+      return false;
+    }
+    
+    MappedFile file;
+    Ktx2Image image;
+    if(!file.open(cooked.string()) || !readKtx2(file.bytes(), image)) {
+      Logger::warn("Cooked texture {} is not a supported KTX2 file", cooked.string());
+      return false;
+    }
+    
+    vk::Format format = static_cast<vk::Format>(image.format);
+    auto features = pDev.getFormatProperties(format).optimalTilingFeatures;
+    auto required = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear | vk::FormatFeatureFlagBits::eTransferDst;
+    if((features & required) != required) {
+      Logger::info("Device can't sample {} of {}, loading the source", vk::to_string(format), cooked.string());
       return false;
     }
     
-    vk::raii::Buffer stagingBuf({nullptr});
-    vk::raii::DeviceMemory stagingBufMem({nullptr});
+    m_cookedPath = cooked.string();
+    m_width = image.width;
+    m_height = image.height;
+    m_format = format;
+    m_mipLevels = static_cast<uint32_t>(image.levels.size());
+    m_stagedMips = m_mipLevels;
+    m_cooked = std::move(image);
+    
+    return true;
+  }
+  
+  bool VulkanTexture::createTextureImg(
+    const std::string& path,
+    vk::raii::PhysicalDevice& pDev,
+    vk::raii::Device& lDev,
+    VulkanAllocator& allocator,
+    bool stageAllMips
+  ) {
+    
+    // only the header here, the pixels are decoded later, possibly on a worker
+    if(!openCooked(path, pDev)) {
+      int texWidth, texHeight, texChannels;
+      if(!stbi_info(path.data(), &texWidth, &texHeight, &texChannels)) {
+        Logger::error("Failed to load texture image {}: {}", path, stbi_failure_reason());
+        return false;
+      }
+      m_width = static_cast<uint32_t>(texWidth);
+      m_height = static_cast<uint32_t>(texHeight);
+      m_format = vk::Format::eR8G8B8A8Srgb;
+      m_mipLevels = getMipLevels(m_width, m_height);
+      
+      // the chain is blitted on the GPU when the format can be linearly filtered, otherwise decode builds it;
+      // streaming needs the small levels before the big one is uploaded, so decode builds it then too
+      auto features = pDev.getFormatProperties(m_format).optimalTilingFeatures;
+      auto blitFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+      m_stagedMips = !stageAllMips && (features & blitFeatures) == blitFeatures ? 1 : m_mipLevels;
+    }
+    
+    if(!createImage(
+      m_width,
+      m_height,
+      m_format,
+      vk::ImageTiling::eOptimal,
+      vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eSampled,
+      vk::MemoryPropertyFlagBits::eDeviceLocal,
+      m_texImg,
+      m_texImgAlloc,
+      allocator,
+      lDev,
+      m_mipLevels
+    )) return false;
     
-    if(!createBuf(
-      imgSize,
+    return createStaging(lDev, allocator);
+  }
+  
+  bool VulkanTexture::createStaging(vk::raii::Device& lDev, VulkanAllocator& allocator) {
+    
+    // a dedicated buffer rather than the staging ring: decodes finish out of order and may not fit it
+    return createBuf(
+      getChainSize(m_format, m_width, m_height, m_stagedMips),
       vk::BufferUsageFlagBits::eTransferSrc,
       vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-      stagingBuf,
-      stagingBufMem,
-      pDev,
-      lDev
-    )) return false;
-    void* data = stagingBufMem.mapMemory(0, imgSize);
-    memcpy(data, pixels, imgSize);
-    stagingBufMem.unmapMemory();
-    stbi_image_free(pixels);
+      m_staging,
+      m_stagingAlloc,
+      allocator,
+      lDev,
+      VMA_ALLOCATION_CREATE_MAPPED_BIT
+    );
+  }
+  
+  bool VulkanTexture::downscale(vk::raii::Device& lDev, VulkanAllocator& allocator, VulkanUploader& uploader, VulkanDeletionQueue& deletion) {
+    
+    // still waiting for its pixels
+    if(m_decode.valid() || m_placeholder) return false;
+    if(m_mipLevels < 2 || (m_width <= TEXTURE_MIN_EVICT_SIZE && m_height <= TEXTURE_MIN_EVICT_SIZE)) return false;
+    // staged but not recorded yet, or streaming: only a streaming texture can let go of it
+    if(*m_staging && !releaseStaging(uploader)) return false;
     
+    uint32_t w = getMipSize(m_width, 1);
+    uint32_t h = getMipSize(m_height, 1);
+    uint32_t mipLevels = m_mipLevels - 1;
+    // levels above the resident one hold nothing, only the rest is carried over
+    uint32_t resident = std::max(m_residentMip, 1u) - 1;
+    
+    vk::raii::Image img{nullptr};
+    VulkanAllocation alloc{nullptr};
     if(!createImage(
-      texWidth,
-      texHeight,
-      vk::Format::eR8G8B8A8Srgb,
+      w,
+      h,
+      m_format,
       vk::ImageTiling::eOptimal,
-      vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+      vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eSampled,
       vk::MemoryPropertyFlagBits::eDeviceLocal,
-      m_texImg,
-      m_texImgMem,
-      pDev,
-      lDev
+      img,
+      alloc,
+      allocator,
+      lDev,
+      mipLevels
     )) return false;
     
-    if(!transitionImageLayout(lDev, cmdPool, graphQ, m_texImg, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal)) return false;
-    if(!copyBufToImg(stagingBuf, m_texImg, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), lDev, cmdPool, graphQ)) return false;
-    if(!transitionImageLayout(lDev, cmdPool, graphQ, m_texImg, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal)) return false;
+    vk::raii::ImageView view{nullptr};
+    if(!createImgView(*img, m_format, vk::ImageAspectFlagBits::eColor, view, lDev, mipLevels - resident, resident)) return false;
+    
+    // level i + 1 of the old image is level i of the new one, a plain copy
+    if(  !uploader.transitionImage(img, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 0, mipLevels)
+      || !uploader.transitionImage(m_texImg, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal, resident + 1, mipLevels - resident)
+    ) return false;
+    for(uint32_t i = resident; i < mipLevels; ++i) {
+      if(!uploader.copyImage(m_texImg, img, getMipSize(w, i), getMipSize(h, i), i + 1, i)) return false;
+    }
+    if(!uploader.transitionImage(img, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, resident, mipLevels - resident)) return false;
+    
+    deletion.push(std::move(m_texImgView), std::move(m_texImg), std::move(m_texImgAlloc));
+    m_texImg = std::move(img);
+    m_texImgAlloc = std::move(alloc);
+    m_texImgView = std::move(view);
+    
+    Logger::info("Texture {} dropped to {}x{}", s_path, w, h);
     
+    m_width = w;
+    m_height = h;
+    m_mipLevels = mipLevels;
+    m_residentMip = resident;
+    // the source no longer matches the image, the missing levels are gone for good
+    m_restage = false;
+    ++m_version;
     return true;
   }
   
@@ -88,10 +531,11 @@ namespace V {
     
     if(!createImgView(
       *m_texImg,
-      vk::Format::eR8G8B8A8Srgb,
+      m_format,
       vk::ImageAspectFlagBits::eColor,
       m_texImgView,
-      lDev
+      lDev,
+      m_mipLevels
     )) {
       return false;
     }
@@ -120,7 +564,7 @@ namespace V {
       .compareEnable = vk::False,
       .compareOp = vk::CompareOp::eAlways,
       .minLod = 0.f,
-      .maxLod = 0.f,
+      .maxLod = vk::LodClampNone,
       .borderColor = vk::BorderColor::eIntOpaqueBlack,
       .unnormalizedCoordinates = vk::False
     };
@@ -1,10 +1,20 @@
 #pragma once
 
-#include "vk_image.hpp"
+#include "vk_deletion.hpp"
+#include "../../tools/threadPool/threadpool.hpp"
+#include "../../tools/ktx2/ktx2.hpp"
 
 
 namespace V {
   
+  // eviction order under memory pressure, lowest first; resident textures are never touched
+  enum class TexturePriority : uint8_t {
+    eLow,
+    eNormal,
+    eHigh,
+    eResident
+  };
+  
   // "../../assets/textures/txtr.jpg"
   class VulkanTexture {
   public:
@@ -16,26 +26,108 @@ namespace V {
       std::string& path,
       vk::raii::PhysicalDevice& pDev,
       vk::raii::Device& lDev,
-      vk::raii::CommandPool& cmdPool,
-      vk::raii::Queue& graphQ
+      VulkanAllocator& allocator,
+      VulkanUploader& uploader
+    );
+    
+    // 1x1 RGBA8 texel recorded into the open batch, stands in for materials without a texture
+    bool initSolid(
+      uint32_t rgba,
+      vk::raii::PhysicalDevice& pDev,
+      vk::raii::Device& lDev,
+      VulkanAllocator& allocator,
+      VulkanUploader& uploader
     );
     
+    // creates the image from the file header and starts decoding into staging memory on `workers`;
+    // a cooked <name>.ktx2 next to `path` is used instead when it is up to date and the device samples its format.
+    // with `workers` every level is staged on the CPU, so the texture can be streamed smallest level first
+    bool load(
+      const std::string& path,
+      vk::raii::PhysicalDevice& pDev,
+      vk::raii::Device& lDev,
+      VulkanAllocator& allocator,
+      ThreadPool* workers
+    );
+    // waits for the decode and records the copy, the texture is ready once the upload batch is done
+    bool finishLoad(VulkanUploader& uploader);
+    
+    // non-blocking alternative to finishLoad(): the smallest level is resident right away,
+    // a grey texel until the decode lands, larger ones follow through stream().
+    // false only if the upload could not be recorded, a failed decode shows up as a placeholder
+    bool beginStreaming(VulkanUploader& uploader, vk::raii::Device& lDev, VulkanDeletionQueue& deletion);
+    // records levels above the resident one, smallest first, down to the wanted one and about `budget` bytes;
+    // a level bigger than the whole budget still goes alone. Returns the bytes recorded
+    vk::DeviceSize stream(VulkanUploader& uploader, vk::raii::Device& lDev, VulkanDeletionQueue& deletion, vk::DeviceSize budget);
+    bool isStreaming() const { return m_streaming && *m_staging; }
+    // once per frame while streaming, before resetRequest(): staging goes back after TEXTURE_STAGING_IDLE_FRAMES
+    // without a larger level wanted, restage() decodes it again once one is
+    void releaseIdleStaging(VulkanUploader& uploader);
+    bool needsRestage() const { return m_restage && getWantedMip() < m_residentMip; }
+    bool restage(vk::raii::Device& lDev, VulkanAllocator& allocator, ThreadPool* workers);
+    
+    // on-screen size in pixels of something sampling the texture, the largest request since resetRequest() wins
+    void requestSize(uint32_t pixels) { m_requestedSize = std::max(m_requestedSize, pixels); }
+    void resetRequest() { m_requestedSize = 0; }
+    // smallest level still at least the requested size, the last one while nothing asks
+    uint32_t getWantedMip() const;
+    uint32_t getResidentMip() const { return m_residentMip; }
+    // the resident level is still the grey texel, stream() replaces it whatever the wanted level
+    bool hasPlaceholder() const { return m_placeholder; }
+    
     vk::raii::ImageView& getImgView() { return m_texImgView; }
     vk::raii::Sampler& getSampler() { return m_texSampler; }
     
+    // drops the top mip: re-creates the image from the smaller resident levels, the old image goes to the deletion queue.
+    // a streaming texture gives up its staging memory and does not grow back; returns false once the texture
+    // is at TEXTURE_MIN_EVICT_SIZE or still waiting for its pixels
+    bool downscale(vk::raii::Device& lDev, VulkanAllocator& allocator, VulkanUploader& uploader, VulkanDeletionQueue& deletion);
+    
+    void setPriority(TexturePriority priority) { m_priority = priority; }
+    TexturePriority getPriority() const { return m_priority; }
+    vk::DeviceSize getByteSize() const { return getChainSize(m_format, m_width, m_height, m_mipLevels); }
+    uint32_t getWidth() const { return m_width; }
+    uint32_t getHeight() const { return m_height; }
+    uint32_t getMipLevels() const { return m_mipLevels; }
+    // bumped whenever the image view changes, descriptor sets referencing the old one must be rewritten
+    uint32_t getVersion() const { return m_version; }
+    
     std::string s_path;
   
   private:
     
     bool createTextureImg(
-      std::string& path,
+      const std::string& path,
       vk::raii::PhysicalDevice& pDev,
       vk::raii::Device& lDev,
-      vk::raii::CommandPool& cmdPool,
-      vk::raii::Queue& graphQ
+      VulkanAllocator& allocator,
+      bool stageAllMips
     );
     
+    bool openCooked(const std::string& path, vk::raii::PhysicalDevice& pDev);
+    // host-visible buffer for the first m_stagedMips levels
+    bool createStaging(vk::raii::Device& lDev, VulkanAllocator& allocator);
+    // false while a worker still writes into it
+    bool releaseStaging(VulkanUploader& uploader);
+    
+    // runs on a worker, fills the mapped staging buffer from whichever file load() picked
+    bool decodeStaging() const;
+    // waits for the decode, a failed one leaves a placeholder in staging
+    bool collectDecode();
+    // copies the staged levels, or the top one and blits the rest; false if nothing could be recorded
+    bool recordLoad(VulkanUploader& uploader);
+    // RGBA8 pixels followed by `mipLevels` - 1 box-filtered levels
+    static bool decode(const std::string& path, uint32_t w, uint32_t h, uint32_t mipLevels, void* dst);
+    static void downsample(const uint32_t* src, uint32_t srcW, uint32_t srcH, uint32_t* dst);
+    // every level of the cooked file as stored, after checking it still matches `expected`
+    static bool decodeCooked(const std::string& path, const Ktx2Image& expected, void* dst);
+    
+    // bytes of the first `mipLevels` levels, tightly packed one after another
+    static vk::DeviceSize getChainSize(vk::Format format, uint32_t w, uint32_t h, uint32_t mipLevels);
+    
     bool createTextureImgView(vk::raii::Device& lDev);
+    // the view only covers levels holding data, switching it bumps the version
+    bool setResidentMip(uint32_t mip, vk::raii::Device& lDev, VulkanDeletionQueue& deletion);
     
     bool createTextureSampler(
       vk::raii::PhysicalDevice& pDev,
@@ -43,10 +135,32 @@ namespace V {
     );
     
     vk::raii::Image m_texImg{nullptr};
-    vk::raii::DeviceMemory m_texImgMem{nullptr};
+    VulkanAllocation m_texImgAlloc{nullptr};
     vk::raii::ImageView m_texImgView{nullptr};
     vk::raii::Sampler m_texSampler{nullptr};
     
+    vk::raii::Buffer m_staging{nullptr};
+    VulkanAllocation m_stagingAlloc{nullptr};
+    std::future<bool> m_decode;
+    
+    // level layout of the .ktx2 being loaded, no levels when decoding the source through stb
+    std::string m_cookedPath;
+    Ktx2Image m_cooked;
+    
+    uint32_t m_width{0};
+    uint32_t m_height{0};
+    vk::Format m_format{vk::Format::eR8G8B8A8Srgb};
+    uint32_t m_mipLevels{1};
+    uint32_t m_stagedMips{1}; // levels decode writes into staging, the rest are blitted on the GPU
+    uint32_t m_residentMip{0}; // first level the view covers
+    uint32_t m_requestedSize{0};
+    bool m_streaming{false};
+    bool m_placeholder{false}; // the last level holds the grey texel, not decoded data
+    bool m_restage{false}; // staging was released early, the levels above the resident one can be decoded again
+    uint32_t m_idleFrames{0};
+    uint32_t m_version{0};
+    TexturePriority m_priority{TexturePriority::eNormal};
+    
   };
   
   
@@ -0,0 +1,113 @@
+#include "vk_texture_cache.hpp"
+
+#include <filesystem>
+#include <algorithm>
+
+namespace V {
+  
+  VulkanTextureCache::VulkanTextureCache() {
+    
+  }
+  
+  VulkanTextureCache::~VulkanTextureCache() {
+    
+  }
+  
+  bool VulkanTextureCache::init(
+    vk::raii::PhysicalDevice& pDev,
+    vk::raii::Device& lDev,
+    VulkanAllocator& allocator,
+    VulkanUploader& uploader,
+    VulkanDeletionQueue& deletion,
+    VulkanMemoryBudget& budget,
+    ThreadPool& workers
+  ) {
+    
+    m_pDev = &pDev;
+    m_lDev = &lDev;
+    m_allocator = &allocator;
+    m_uploader = &uploader;
+    m_deletion = &deletion;
+    m_budget = &budget;
+    m_workers = &workers;
+    
+    return true;
+  }
+  
+  std::shared_ptr<VulkanTexture> VulkanTextureCache::acquire(const std::string& path) {
+    
+    // "a/../textures/x.png" and "textures/x.png" must hit the same entry
+    std::error_code ec;
+    std::string key = std::filesystem::weakly_canonical(path, ec).string();
+    if(ec) key = std::filesystem::path(path).lexically_normal().string();
+    
+    auto it = m_entries.find(key);
+    if(it != m_entries.end()) {
+      if(auto tex = it->second.lock()) {
+        ++m_hits;
+        return tex;
+      }
+    }
+    
+    ++m_misses;
+    std::erase_if(m_entries, [](const auto& entry) { return entry.second.expired(); });
+    
+    auto tex = std::make_shared<VulkanTexture>();
+    if(!tex->load(path, *m_pDev, *m_lDev, *m_allocator, m_workers)) {
+      return nullptr;
+    }
+    
+    m_entries[key] = tex;
+    m_budget->track(tex);
+    return tex;
+  }
+  
+  std::shared_ptr<VulkanTexture> VulkanTextureCache::getFallback() {
+    
+    if(m_fallback) return m_fallback;
+    
+    // too small to be worth tracking in the budget
+    auto tex = std::make_shared<VulkanTexture>();
+    if(!tex->initSolid(0xFFFFFFFFu, *m_pDev, *m_lDev, *m_allocator, *m_uploader)) {
+      Logger::error("Failed to create fallback texture");
+      return nullptr;
+    }
+    
+    m_fallback = tex;
+    return m_fallback;
+  }
+  
+  void VulkanTextureCache::stream(vk::DeviceSize budget) {
+    
+    std::vector<std::shared_ptr<VulkanTexture>> live;
+    std::vector<std::shared_ptr<VulkanTexture>> pending;
+    for(const auto& [key, entry] : m_entries) {
+      auto tex = entry.lock();
+      if(!tex) continue;
+      // its staging went back while nothing asked for more
+      if(tex->needsRestage()) tex->restage(*m_lDev, *m_allocator, m_workers);
+      if(tex->isStreaming()) pending.push_back(tex);
+      live.push_back(std::move(tex));
+    }
+    
+    // how many levels short of what the screen asks for, a placeholder counts as one more
+    auto gap = [](const auto& tex) {
+      return static_cast<int>(tex->getResidentMip()) - static_cast<int>(tex->getWantedMip()) + (tex->hasPlaceholder() ? 1 : 0);
+    };
+    std::ranges::sort(pending, [&](const auto& a, const auto& b) { return gap(a) > gap(b); });
+    
+    for(const auto& tex : pending) {
+      if(budget == 0 || gap(tex) <= 0) break;
+      vk::DeviceSize used = tex->stream(*m_uploader, *m_lDev, *m_deletion, budget);
+      budget = used >= budget ? 0 : budget - used;
+    }
+    
+    for(const auto& tex : pending) tex->releaseIdleStaging(*m_uploader);
+    for(const auto& tex : live) tex->resetRequest();
+  }
+  
+  void VulkanTextureCache::logStats() const {
+    Logger::info("Texture cache: {} textures, {} hits / {} misses", m_entries.size(), m_hits, m_misses);
+  }
+  
+}; //V
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "vk_budget.hpp"
+
+#include <unordered_map>
+
+namespace V {
+  
+  // one GPU image per file for the whole process; entries are weak, a texture lives as long as
+  // some model (or the deletion queue) still holds it
+  class VulkanTextureCache {
+  public:
+    
+    VulkanTextureCache();
+    ~VulkanTextureCache();
+    
+    VulkanTextureCache(const VulkanTextureCache&) = delete;
+    VulkanTextureCache& operator=(const VulkanTextureCache&) = delete;
+    
+    bool init(
+      vk::raii::PhysicalDevice& pDev,
+      vk::raii::Device& lDev,
+      VulkanAllocator& allocator,
+      VulkanUploader& uploader,
+      VulkanDeletionQueue& deletion,
+      VulkanMemoryBudget& budget,
+      ThreadPool& workers
+    );
+    
+    // a miss starts decoding on the workers; callers beginStreaming() every texture they got before flushing,
+    // only the first call does any work
+    std::shared_ptr<VulkanTexture> acquire(const std::string& path);
+    // white texel for materials without a diffuse texture, created on first use and kept until the cache goes away
+    std::shared_ptr<VulkanTexture> getFallback();
+    
+    // once per frame after models requested their on-screen sizes: records the next levels of streaming
+    // textures into the open upload batch, the ones furthest below their wanted level first
+    void stream(vk::DeviceSize budget = TEXTURE_STREAM_FRAME_BUDGET);
+    
+    void logStats() const;
+  
+  private:
+    
+    vk::raii::PhysicalDevice* m_pDev{nullptr};
+    vk::raii::Device* m_lDev{nullptr};
+    VulkanAllocator* m_allocator{nullptr};
+    VulkanUploader* m_uploader{nullptr};
+    VulkanDeletionQueue* m_deletion{nullptr};
+    VulkanMemoryBudget* m_budget{nullptr};
+    ThreadPool* m_workers{nullptr};
+    
+    std::unordered_map<std::string, std::weak_ptr<VulkanTexture>> m_entries; // canonical path -> texture
+    std::shared_ptr<VulkanTexture> m_fallback;
+    uint32_t m_hits{0};
+    uint32_t m_misses{0};
+    
+  };
+  
+}; //V
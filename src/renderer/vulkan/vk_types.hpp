@@ -17,6 +17,7 @@
 #include <limits>
 #include <fstream>
 #include <set>
+#include <bit>
 
 
 
@@ -36,5 +37,29 @@
 namespace V {
   
   const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+  const uint64_t STAGING_RING_SIZE = 64ull * 1024 * 1024;
+  const uint32_t GEOMETRY_POOL_VERTICES = 256 * 1024;
+  const uint32_t GEOMETRY_POOL_INDICES = 1024 * 1024;
+  const uint64_t UNIFORM_RING_FRAME_SIZE = 4ull * 1024 * 1024;
+  const float MEMORY_BUDGET_PRESSURE = 0.9f; // share of a heap's budget after which textures start being evicted
+  const uint32_t TEXTURE_MIN_EVICT_SIZE = 64;
+  const char* const PIPELINE_CACHE_PATH = "pipeline.cache"; // relative to the working directory, only valid for this GPU and driver
+  const uint32_t MAX_MATERIALS = 100; // descriptor pool capacity, each material holds MATERIAL_DESC_SETS sets
+  const uint32_t MATERIAL_DESC_SETS = MAX_FRAMES_IN_FLIGHT + 1; // one more than frames can have bound
+  const uint64_t TEXTURE_STREAM_FRAME_BUDGET = 16ull * 1024 * 1024; // texture level bytes uploaded per frame, one level may overshoot it
+  const uint32_t TEXTURE_STAGING_IDLE_FRAMES = 120; // frames a streaming texture keeps its staging memory without wanting a larger level
+  
+  // FNV-1a, the same on every run and platform
+  inline uint64_t hashBytes(std::span<const std::byte> bytes, uint64_t seed = 14695981039346656037ull) {
+    for(std::byte b : bytes) {
+      seed ^= static_cast<uint64_t>(b);
+      seed *= 1099511628211ull;
+    }
+    return seed;
+  }
+  
+  inline void hashCombine(size_t& seed, size_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+  }
   
 }; //V
\ No newline at end of file
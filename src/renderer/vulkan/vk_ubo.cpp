@@ -0,0 +1,63 @@
+#include "vk_ubo.hpp"
+
+namespace V {
+  
+  VulkanUniformRing::VulkanUniformRing() {
+    
+  }
+  
+  VulkanUniformRing::~VulkanUniformRing() {
+    
+  }
+  
+  bool VulkanUniformRing::init(
+    VulkanAllocator& allocator,
+    vk::raii::PhysicalDevice& pDev,
+    vk::raii::Device& lDev,
+    vk::DeviceSize frameSize
+  ) {
+    
+    m_align = std::max<vk::DeviceSize>(pDev.getProperties().limits.minUniformBufferOffsetAlignment, 1);
+    m_frameSize = (frameSize + m_align - 1) / m_align * m_align;
+    
+    if(!createBuf(
+      m_frameSize * MAX_FRAMES_IN_FLIGHT,
+      vk::BufferUsageFlagBits::eUniformBuffer,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+      m_buf,
+      m_alloc,
+      allocator,
+      lDev,
+      VMA_ALLOCATION_CREATE_MAPPED_BIT
+    )) {
+      Logger::error("Failed to create uniform ring");
+      return false;
+    }
+    
+    m_mapped = static_cast<std::byte*>(m_alloc.getMapped());
+    m_frameBegin = 0;
+    m_head = 0;
+    
+    return true;
+  }
+  
+  void VulkanUniformRing::beginFrame(uint32_t curFrame) {
+    m_frameBegin = m_frameSize * curFrame;
+    m_head = m_frameBegin;
+  }
+  
+  std::optional<uint32_t> VulkanUniformRing::push(const void* data, vk::DeviceSize size) {
+    
+    vk::DeviceSize begin = (m_head + m_align - 1) / m_align * m_align;
+    if(begin + size > m_frameBegin + m_frameSize) {
+      Logger::error("Uniform ring out of space: {} bytes used this frame", m_head - m_frameBegin);
+      return std::nullopt;
+    }
+    
+    memcpy(m_mapped + begin, data, size);
+    m_head = begin + size;
+    
+    return static_cast<uint32_t>(begin);
+  }
+  
+}; //V
@@ -17,56 +17,49 @@ namespace V {
     alignas(16) glm::mat4 bones[MAX_BONES];
   };
   
-  template<typename T>
-  class UBOManager {
+  // one persistently mapped buffer split into a region per frame in flight;
+  // each push hands out the next aligned slice of the current frame's region,
+  // the returned offset goes into bindDescriptorSets as a dynamic offset
+  class VulkanUniformRing {
   public:
     
-    UBOManager() {}
-    ~UBOManager() {}
+    VulkanUniformRing();
+    ~VulkanUniformRing();
     
-    bool init(vk::raii::PhysicalDevice& pDev, vk::raii::Device& lDev) {
-      if(!createUBufs(pDev, lDev)) return false;
-      return true;
-    }
+    VulkanUniformRing(const VulkanUniformRing&) = delete;
+    VulkanUniformRing& operator=(const VulkanUniformRing&) = delete;
+    
+    bool init(
+      VulkanAllocator& allocator,
+      vk::raii::PhysicalDevice& pDev,
+      vk::raii::Device& lDev,
+      vk::DeviceSize frameSize = UNIFORM_RING_FRAME_SIZE
+    );
+    
+    // only call once the frame's fence has been waited on
+    void beginFrame(uint32_t curFrame);
     
-    std::vector<vk::raii::Buffer>& getUBufs() { return m_uniformBufs; }
+    std::optional<uint32_t> push(const void* data, vk::DeviceSize size);
     
-    void update(const T& data, uint32_t curFrame) {
-      memcpy(m_uniformBufsMapped[curFrame], &data, sizeof(T));
+    template<typename T>
+    std::optional<uint32_t> push(const T& data) {
+      return push(&data, sizeof(T));
     }
     
+    vk::raii::Buffer& getBuf() { return m_buf; }
+    vk::DeviceSize getUsed() const { return m_head - m_frameBegin; }
+    
   private:
-    bool createUBufs(vk::raii::PhysicalDevice& pDev, vk::raii::Device& lDev) {
-      m_uniformBufs.clear();
-      m_uniformBufsMem.clear();
-      m_uniformBufsMapped.clear();
-      
-      for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-        vk::DeviceSize bufSize = sizeof(T);
-        vk::raii::Buffer buf{nullptr};
-        vk::raii::DeviceMemory bufMem{nullptr};
-        if(!createBuf(
-          bufSize,
-          vk::BufferUsageFlagBits::eUniformBuffer,
-          vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-          buf,
-          bufMem,
-          pDev,
-          lDev
-        )) return false;
-        
-        m_uniformBufs.emplace_back(std::move(buf));
-        m_uniformBufsMem.emplace_back(std::move(bufMem));
-        m_uniformBufsMapped.emplace_back(m_uniformBufsMem[i].mapMemory(0, bufSize));
-      }
-      
-      return true;
-    }
     
-    std::vector<vk::raii::Buffer> m_uniformBufs;
-    std::vector<vk::raii::DeviceMemory> m_uniformBufsMem;
-    std::vector<void*> m_uniformBufsMapped;
+    vk::raii::Buffer m_buf{nullptr};
+    VulkanAllocation m_alloc{nullptr};
+    std::byte* m_mapped{nullptr};
+    
+    vk::DeviceSize m_frameSize{0};
+    vk::DeviceSize m_align{1};
+    vk::DeviceSize m_frameBegin{0};
+    vk::DeviceSize m_head{0};
     
   };
   
-};
\ No newline at end of file
+}; //V
@@ -0,0 +1,331 @@
+#include "vk_upload.hpp"
+
+namespace V {
+  
+  VulkanUploader::VulkanUploader() {
+    
+  }
+  
+  VulkanUploader::~VulkanUploader() {
+    if(m_nextTicket > 1) {
+      wait(m_nextTicket - 1);
+    }
+  }
+  
+  bool VulkanUploader::init(
+    vk::raii::Device& lDev,
+    vk::raii::Queue& graphQ,
+    uint32_t queueFamily,
+    VulkanAllocator& allocator,
+    vk::DeviceSize stagingSize
+  ) {
+    
+    m_lDev = &lDev;
+    m_graphQ = &graphQ;
+    m_allocator = &allocator;
+    
+    if(!m_ring.init(allocator, lDev, stagingSize)) {
+      return false;
+    }
+    
+    vk::CommandPoolCreateInfo poolInfo{
+      .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient,
+      .queueFamilyIndex = queueFamily
+    };
+    
+    {
+      auto res = lDev.createCommandPool(poolInfo);
+      if(!res) {
+        Logger::error("Failed to create upload command pool: {}", vk::to_string(res.error()));
+        return false;
+      }
+      m_cmdPool = std::move(res.value());
+    }
+    
+    vk::SemaphoreTypeCreateInfo typeInfo{
+      .semaphoreType = vk::SemaphoreType::eTimeline,
+      .initialValue = 0
+    };
+    
+    {
+      auto res = lDev.createSemaphore(vk::SemaphoreCreateInfo{.pNext = &typeInfo});
+      if(!res) {
+        Logger::error("Failed to create upload timeline semaphore: {}", vk::to_string(res.error()));
+        return false;
+      }
+      m_timeline = std::move(res.value());
+    }
+    
+    return true;
+  }
+  
+  bool VulkanUploader::record() {
+    
+    if(m_open) return true;
+    
+    std::unique_ptr<Batch> batch;
+    if(!m_free.empty()) {
+      batch = std::move(m_free.back());
+      m_free.pop_back();
+      batch->cmdBuf.reset();
+    } else {
+      vk::CommandBufferAllocateInfo allocInfo{
+        .commandPool = m_cmdPool,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1
+      };
+      
+      auto res = m_lDev->allocateCommandBuffers(allocInfo);
+      if(!res) {
+        Logger::error("Failed to allocate upload command buffer: {}", vk::to_string(res.error()));
+        return false;
+      }
+      batch = std::make_unique<Batch>();
+      batch->cmdBuf = std::move(res.value().front());
+    }
+    
+    batch->cmdBuf.begin(vk::CommandBufferBeginInfo{.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    batch->ticket = m_nextTicket;
+    batch->held = std::move(m_orphans);
+    m_orphans.clear();
+    m_open = std::move(batch);
+    
+    return true;
+  }
+  
+  std::optional<StagingSlice> VulkanUploader::stage(vk::DeviceSize size) {
+    
+    // 16 covers the texel block size of every format we copy into images
+    constexpr vk::DeviceSize align = 16;
+    
+    collect();
+    if(auto slice = m_ring.alloc(size, align)) return slice;
+    if(size > m_ring.getSize()) return std::nullopt;
+    
+    // ring is full: submit what is recorded and wait for the oldest batches to give space back
+    flush();
+    while(!m_inFlight.empty()) {
+      wait(m_inFlight.front()->ticket);
+      collect();
+      if(auto slice = m_ring.alloc(size, align)) return slice;
+    }
+    
+    return std::nullopt;
+  }
+  
+  bool VulkanUploader::stageDedicated(const void* data, vk::DeviceSize size, vk::raii::Buffer& buf, VulkanAllocation& alloc) {
+    
+    if(!createBuf(
+      size,
+      vk::BufferUsageFlagBits::eTransferSrc,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+      buf,
+      alloc,
+      *m_allocator,
+      *m_lDev
+    )) return false;
+    
+    void* mapped = alloc.map();
+    if(!mapped) return false;
+    memcpy(mapped, data, size);
+    alloc.unmap();
+    
+    return true;
+  }
+  
+  bool VulkanUploader::uploadBuf(const void* data, vk::DeviceSize size, const vk::raii::Buffer& dst, vk::DeviceSize dstOffset) {
+    
+    if(auto slice = stage(size)) {
+      memcpy(slice->data, data, size);
+      // the open batch's ticket, or the next one's if the copy cannot be recorded
+      m_ring.retire(*slice, m_nextTicket);
+      return copyBuffer(m_ring.getBuf(), dst, size, slice->offset, dstOffset);
+    }
+    
+    // bigger than the whole ring
+    vk::raii::Buffer buf{nullptr};
+    VulkanAllocation alloc{nullptr};
+    if(!stageDedicated(data, size, buf, alloc)) return false;
+    
+    if(!copyBuffer(buf, dst, size, 0, dstOffset)) return false;
+    keepAlive(std::move(buf), std::move(alloc));
+    return true;
+  }
+  
+  bool VulkanUploader::uploadImg(const void* data, vk::DeviceSize size, const vk::raii::Image& img, uint32_t w, uint32_t h, uint32_t mip) {
+    
+    if(auto slice = stage(size)) {
+      memcpy(slice->data, data, size);
+      m_ring.retire(*slice, m_nextTicket);
+      return copyBufToImg(m_ring.getBuf(), img, w, h, slice->offset, mip);
+    }
+    
+    vk::raii::Buffer buf{nullptr};
+    VulkanAllocation alloc{nullptr};
+    if(!stageDedicated(data, size, buf, alloc)) return false;
+    
+    if(!copyBufToImg(buf, img, w, h, 0, mip)) return false;
+    keepAlive(std::move(buf), std::move(alloc));
+    return true;
+  }
+  
+  bool VulkanUploader::copyBuffer(
+    const vk::raii::Buffer& src,
+    const vk::raii::Buffer& dst,
+    vk::DeviceSize size,
+    vk::DeviceSize srcOffset,
+    vk::DeviceSize dstOffset
+  ) {
+    if(!record()) return false;
+    V::copyBuffer(m_open->cmdBuf, src, dst, size, srcOffset, dstOffset);
+    return true;
+  }
+  
+  bool VulkanUploader::copyRegions(
+    const vk::raii::Buffer& src,
+    const vk::raii::Buffer& dst,
+    const std::vector<vk::BufferCopy>& regions
+  ) {
+    if(regions.empty()) return true;
+    if(!record()) return false;
+    m_open->cmdBuf.copyBuffer(src, dst, regions);
+    return true;
+  }
+  
+  bool VulkanUploader::copyBufToImg(
+    const vk::raii::Buffer& src,
+    const vk::raii::Image& img,
+    uint32_t w,
+    uint32_t h,
+    vk::DeviceSize srcOffset,
+    uint32_t mip
+  ) {
+    if(!record()) return false;
+    V::copyBufToImg(m_open->cmdBuf, src, img, w, h, srcOffset, mip);
+    return true;
+  }
+  
+  bool VulkanUploader::transitionImage(const vk::Image& img, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t baseMip, uint32_t mipCount) {
+    if(!record()) return false;
+    return transitionImageLayout(m_open->cmdBuf, img, oldLayout, newLayout, {}, {}, vk::PipelineStageFlagBits2::eTopOfPipe, vk::PipelineStageFlagBits2::eBottomOfPipe, baseMip, mipCount);
+  }
+  
+  bool VulkanUploader::copyImage(const vk::Image& src, const vk::Image& dst, uint32_t w, uint32_t h, uint32_t srcMip, uint32_t dstMip) {
+    if(!record()) return false;
+    copyImg(m_open->cmdBuf, src, dst, w, h, srcMip, dstMip);
+    return true;
+  }
+  
+  bool VulkanUploader::generateMips(const vk::Image& img, uint32_t w, uint32_t h, uint32_t mipLevels) {
+    if(!record()) return false;
+    return V::generateMips(m_open->cmdBuf, img, w, h, mipLevels);
+  }
+  
+  void VulkanUploader::transferBarrier() {
+    
+    if(!m_open) return;
+    
+    vk::MemoryBarrier2 barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .dstAccessMask = vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite
+    };
+    m_open->cmdBuf.pipelineBarrier2(vk::DependencyInfo{
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &barrier
+    });
+  }
+  
+  UploadTicket VulkanUploader::flush() {
+    
+    if(!m_open) return m_nextTicket - 1;
+    
+    // make every copy of the batch visible to whatever reads it next on the queue
+    vk::MemoryBarrier2 barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eVertexInput | vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eTransfer,
+      .dstAccessMask = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead | vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eTransferRead
+    };
+    m_open->cmdBuf.pipelineBarrier2(vk::DependencyInfo{
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &barrier
+    });
+    
+    m_open->cmdBuf.end();
+    
+    UploadTicket ticket = m_open->ticket;
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{
+      .signalSemaphoreValueCount = 1,
+      .pSignalSemaphoreValues = &ticket
+    };
+    
+    const vk::SubmitInfo submitInfo{
+      .pNext = &timelineInfo,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &*m_open->cmdBuf,
+      .signalSemaphoreCount = 1,
+      .pSignalSemaphores = &*m_timeline
+    };
+    m_graphQ->submit(submitInfo, nullptr);
+    
+    m_inFlight.emplace_back(std::move(m_open));
+    ++m_nextTicket;
+    
+    return ticket;
+  }
+  
+  bool VulkanUploader::isDone(UploadTicket ticket) {
+    
+    if(ticket <= m_completed) return true;
+    if(ticket >= m_nextTicket) return false;
+    
+    vk::SemaphoreWaitInfo waitInfo{
+      .semaphoreCount = 1,
+      .pSemaphores = &*m_timeline,
+      .pValues = &ticket
+    };
+    
+    if(m_lDev->waitSemaphores(waitInfo, 0) != vk::Result::eSuccess) return false;
+    
+    m_completed = ticket;
+    return true;
+  }
+  
+  bool VulkanUploader::wait(UploadTicket ticket) {
+    
+    if(ticket <= m_completed) return true;
+    if(ticket == m_nextTicket && m_open) {
+      flush();
+    }
+    if(ticket >= m_nextTicket) return false;
+    
+    vk::SemaphoreWaitInfo waitInfo{
+      .semaphoreCount = 1,
+      .pSemaphores = &*m_timeline,
+      .pValues = &ticket
+    };
+    
+    if(m_lDev->waitSemaphores(waitInfo, UINT64_MAX) != vk::Result::eSuccess) {
+      Logger::error("Failed to wait for upload batch {}", ticket);
+      return false;
+    }
+    
+    m_completed = ticket;
+    return true;
+  }
+  
+  void VulkanUploader::collect() {
+    while(!m_inFlight.empty() && isDone(m_inFlight.front()->ticket)) {
+      auto batch = std::move(m_inFlight.front());
+      m_inFlight.pop_front();
+      
+      batch->held.clear();
+      m_free.emplace_back(std::move(batch));
+    }
+    
+    m_ring.reclaim(m_completed);
+  }
+  
+}; //V
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "vk_image.hpp"
+#include "vk_staging.hpp"
+
+namespace V {
+  
+  // timeline value signaled when the batch that recorded an upload finishes
+  using UploadTicket = uint64_t;
+  
+  class VulkanUploader {
+  public:
+    
+    VulkanUploader();
+    ~VulkanUploader();
+    
+    VulkanUploader(const VulkanUploader&) = delete;
+    VulkanUploader& operator=(const VulkanUploader&) = delete;
+    
+    bool init(
+      vk::raii::Device& lDev,
+      vk::raii::Queue& graphQ,
+      uint32_t queueFamily,
+      VulkanAllocator& allocator,
+      vk::DeviceSize stagingSize = STAGING_RING_SIZE
+    );
+    
+    // copy host data through the staging ring into a device-local resource
+    bool uploadBuf(const void* data, vk::DeviceSize size, const vk::raii::Buffer& dst, vk::DeviceSize dstOffset = 0);
+    bool uploadImg(const void* data, vk::DeviceSize size, const vk::raii::Image& img, uint32_t w, uint32_t h, uint32_t mip = 0);
+    
+    // commands are recorded into the open batch, nothing is submitted until flush();
+    // false if no batch could be opened, nothing was recorded then
+    bool copyBuffer(const vk::raii::Buffer& src, const vk::raii::Buffer& dst, vk::DeviceSize size, vk::DeviceSize srcOffset = 0, vk::DeviceSize dstOffset = 0);
+    bool copyRegions(const vk::raii::Buffer& src, const vk::raii::Buffer& dst, const std::vector<vk::BufferCopy>& regions);
+    bool copyBufToImg(const vk::raii::Buffer& src, const vk::raii::Image& img, uint32_t w, uint32_t h, vk::DeviceSize srcOffset = 0, uint32_t mip = 0);
+    bool transitionImage(const vk::Image& img, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t baseMip = 0, uint32_t mipCount = 1);
+    bool copyImage(const vk::Image& src, const vk::Image& dst, uint32_t w, uint32_t h, uint32_t srcMip = 0, uint32_t dstMip = 0);
+    bool generateMips(const vk::Image& img, uint32_t w, uint32_t h, uint32_t mipLevels);
+    
+    // orders copies already recorded in the open batch before the ones that follow
+    void transferBarrier();
+    
+    // resources handed over here are released once the open batch retires;
+    // the batch is submitted after every frame recorded so far, so that covers their uses too
+    template<typename... T>
+    void keepAlive(T&&... resources) {
+      // without an open batch they ride along with the next one that opens
+      auto& held = record() ? m_open->held : m_orphans;
+      (held.emplace_back(std::make_shared<std::decay_t<T>>(std::move(resources))), ...);
+    }
+    
+    UploadTicket flush();
+    UploadTicket getOpenTicket() const { return m_nextTicket; }
+    // signals once everything recorded so far has executed, the open batch included
+    UploadTicket getRecordedTicket() const { return m_open ? m_nextTicket : m_nextTicket - 1; }
+    
+    bool isDone(UploadTicket ticket);
+    bool wait(UploadTicket ticket);
+    void collect();
+  
+  private:
+    
+    struct Batch {
+      vk::raii::CommandBuffer cmdBuf{nullptr};
+      UploadTicket ticket{0};
+      std::vector<std::shared_ptr<void>> held;
+    };
+    
+    // opens a batch if none is, m_open stays empty when that fails
+    bool record();
+    
+    std::optional<StagingSlice> stage(vk::DeviceSize size);
+    bool stageDedicated(const void* data, vk::DeviceSize size, vk::raii::Buffer& buf, VulkanAllocation& alloc);
+    
+    vk::raii::Device* m_lDev{nullptr};
+    vk::raii::Queue* m_graphQ{nullptr};
+    VulkanAllocator* m_allocator{nullptr};
+    VulkanStagingRing m_ring;
+    vk::raii::CommandPool m_cmdPool{nullptr};
+    vk::raii::Semaphore m_timeline{nullptr};
+    
+    std::unique_ptr<Batch> m_open;
+    std::deque<std::unique_ptr<Batch>> m_inFlight;
+    std::vector<std::unique_ptr<Batch>> m_free;
+    std::vector<std::shared_ptr<void>> m_orphans;
+    
+    UploadTicket m_nextTicket{1};
+    UploadTicket m_completed{0};
+    
+  };
+  
+}; //V
@@ -2,10 +2,13 @@
 
 #include "vk_types.hpp"
 
+#include <glm/gtc/packing.hpp>
+
 namespace V {
   
   const int MAX_BONES_PER_VERTEX = 4;
   
+  // full precision vertex the loaders fill, packed into one of the GPU layouts before upload
   struct Vertex {
     glm::vec3 pos;
     glm::vec3 clr;
@@ -13,20 +16,155 @@ namespace V {
     
     glm::ivec4 boneIDs {-1, -1, -1, -1};
     glm::vec4 weights {0.f, 0.f, 0.f, 0.f};
+  };
+  
+  enum class VertexLayout : uint8_t {
+    eStatic,
+    eSkinned
+  };
+  constexpr uint32_t VERTEX_LAYOUT_COUNT = 2;
+  
+  // binding 0 holds everything a vertex needs to reach clip space,
+  // binding 1 the attributes only the shading passes read
+  enum class VertexStreams : uint8_t {
+    ePosition = 1 << 0,
+    eAttributes = 1 << 1,
+    eAll = ePosition | eAttributes
+  };
+  
+  inline bool hasStream(VertexStreams streams, VertexStreams stream) {
+    return (static_cast<uint8_t>(streams) & static_cast<uint8_t>(stream)) != 0;
+  }
+  
+  // binding 0, 12 bytes
+  struct StaticPosition {
+    glm::vec3 pos;
+  };
+  
+  // binding 0, 20 bytes
+  struct SkinnedPosition {
+    glm::vec3 pos;
+    uint32_t boneIDs;   // uint8x4
+    uint32_t weights;   // unorm8x4, sums to 255
+  };
+  
+  // binding 1, 8 bytes, same for both layouts
+  struct VertexAttributes {
+    uint32_t normal;    // octahedral, snorm16x2
+    uint32_t texCoord;  // half2
+  };
+  
+  inline vk::DeviceSize getPositionStride(VertexLayout layout) {
+    return layout == VertexLayout::eSkinned ? sizeof(SkinnedPosition) : sizeof(StaticPosition);
+  }
+  
+  inline vk::DeviceSize getVertexStride(VertexLayout layout) {
+    return getPositionStride(layout) + sizeof(VertexAttributes);
+  }
+  
+  inline std::string_view getVertexEntry(VertexLayout layout, VertexStreams streams) {
+    if(!hasStream(streams, VertexStreams::eAttributes)) {
+      return layout == VertexLayout::eSkinned ? "vertSkinnedDepth" : "vertStaticDepth";
+    }
+    return layout == VertexLayout::eSkinned ? "vertSkinned" : "vertStatic";
+  }
+  
+  inline std::vector<vk::VertexInputBindingDescription> getBindingDescription(VertexLayout layout, VertexStreams streams) {
+    std::vector<vk::VertexInputBindingDescription> res;
+    if(hasStream(streams, VertexStreams::ePosition)) {
+      res.emplace_back(0, static_cast<uint32_t>(getPositionStride(layout)), vk::VertexInputRate::eVertex);
+    }
+    if(hasStream(streams, VertexStreams::eAttributes)) {
+      res.emplace_back(1, static_cast<uint32_t>(sizeof(VertexAttributes)), vk::VertexInputRate::eVertex);
+    }
+    return res;
+  }
+  
+  inline std::vector<vk::VertexInputAttributeDescription> getAttribDescription(VertexLayout layout, VertexStreams streams) {
+    std::vector<vk::VertexInputAttributeDescription> res;
+    
+    if(hasStream(streams, VertexStreams::ePosition)) {
+      if(layout == VertexLayout::eSkinned) {
+        res.emplace_back(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(SkinnedPosition, pos));
+        res.emplace_back(3, 0, vk::Format::eR8G8B8A8Uint, offsetof(SkinnedPosition, boneIDs));
+        res.emplace_back(4, 0, vk::Format::eR8G8B8A8Unorm, offsetof(SkinnedPosition, weights));
+      } else {
+        res.emplace_back(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(StaticPosition, pos));
+      }
+    }
     
-    static vk::VertexInputBindingDescription getBindingDescription() {
-      return {0, sizeof(Vertex), vk::VertexInputRate::eVertex};
+    if(hasStream(streams, VertexStreams::eAttributes)) {
+      res.emplace_back(1, 1, vk::Format::eR16G16Snorm, offsetof(VertexAttributes, normal));
+      res.emplace_back(2, 1, vk::Format::eR16G16Sfloat, offsetof(VertexAttributes, texCoord));
     }
     
-    static std::array<vk::VertexInputAttributeDescription, 5> getAttribDescription() {
-      return {
-        vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, pos)),
-        vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, clr)),
-        vk::VertexInputAttributeDescription(2, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, texCoord)),
-        vk::VertexInputAttributeDescription(3, 0, vk::Format::eR32G32B32A32Sint, offsetof(Vertex, boneIDs)),
-        vk::VertexInputAttributeDescription(4, 0, vk::Format::eR32G32B32A32Sfloat, offsetof(Vertex, weights)),
-      };
+    return res;
+  }
+  
+  inline uint32_t packOctNormal(glm::vec3 n) {
+    float len = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+    if(len == 0.f) return glm::packSnorm2x16(glm::vec2(0.f));
+    
+    n /= len;
+    glm::vec2 oct(n.x, n.y);
+    if(n.z < 0.f) {
+      oct = (1.f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.f ? 1.f : -1.f, n.y >= 0.f ? 1.f : -1.f);
+    }
+    return glm::packSnorm2x16(oct);
+  }
+  
+  inline void packBones(const Vertex& v, uint32_t& boneIDs, uint32_t& weights) {
+    glm::u8vec4 ids(0);
+    glm::ivec4 w(0);
+    int sum = 0;
+    int largest = 0;
+    
+    for(int i = 0; i < MAX_BONES_PER_VERTEX; ++i) {
+      if(v.boneIDs[i] < 0 || v.weights[i] <= 0.f) continue;
+      ids[i] = static_cast<uint8_t>(v.boneIDs[i]);
+      w[i] = static_cast<int>(glm::round(glm::clamp(v.weights[i], 0.f, 1.f) * 255.f));
+      sum += w[i];
+      if(w[i] > w[largest]) largest = i;
     }
+    
+    // rounding drift goes to the dominant bone so the weights still add up to one
+    if(sum > 0) w[largest] += 255 - sum;
+    
+    boneIDs = ids.x | ids.y << 8 | ids.z << 16 | static_cast<uint32_t>(ids.w) << 24;
+    weights = glm::packUnorm4x8(glm::vec4(w) / 255.f);
+  }
+  
+  struct PackedVertices {
+    std::vector<std::byte> positions;
+    std::vector<std::byte> attributes;
   };
   
-}; //V
\ No newline at end of file
+  // splits the vertices into the two streams of the given layout
+  inline PackedVertices packVertices(const std::vector<Vertex>& verts, VertexLayout layout) {
+    PackedVertices out;
+    out.positions.resize(verts.size() * getPositionStride(layout));
+    out.attributes.resize(verts.size() * sizeof(VertexAttributes));
+    
+    if(layout == VertexLayout::eSkinned) {
+      auto* dst = reinterpret_cast<SkinnedPosition*>(out.positions.data());
+      for(size_t i = 0; i < verts.size(); ++i) {
+        dst[i].pos = verts[i].pos;
+        packBones(verts[i], dst[i].boneIDs, dst[i].weights);
+      }
+    } else {
+      auto* dst = reinterpret_cast<StaticPosition*>(out.positions.data());
+      for(size_t i = 0; i < verts.size(); ++i) {
+        dst[i].pos = verts[i].pos;
+      }
+    }
+    
+    auto* attr = reinterpret_cast<VertexAttributes*>(out.attributes.data());
+    for(size_t i = 0; i < verts.size(); ++i) {
+      attr[i].normal = packOctNormal(verts[i].clr);
+      attr[i].texCoord = glm::packHalf2x16(verts[i].texCoord);
+    }
+    
+    return out;
+  }
+  
+}; //V
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <bit>
+
+namespace V {
+  
+  // the subset of KTX2 the texture cooker writes and VulkanTexture reads:
+  // one 2D image, no array layers or faces, no supercompression, every level present
+  
+  inline constexpr std::byte KTX2_IDENTIFIER[12] = {
+    std::byte{0xAB}, std::byte{'K'}, std::byte{'T'}, std::byte{'X'}, std::byte{' '}, std::byte{'2'},
+    std::byte{'0'}, std::byte{0xBB}, std::byte{'\r'}, std::byte{'\n'}, std::byte{0x1A}, std::byte{'\n'}
+  };
+  
+  // VkFormat values, the cooker does not pull in the Vulkan headers
+  enum class Ktx2Format : uint32_t {
+    eR8G8B8A8Srgb = 43,
+    eBC1RgbUnorm = 131,
+    eBC1RgbSrgb = 132,
+    eBC5Unorm = 141,
+    eBC7Unorm = 145,
+    eBC7Srgb = 146
+  };
+  
+  struct Ktx2Header {
+    std::byte identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+  };
+  static_assert(sizeof(Ktx2Header) == 80);
+  
+  struct Ktx2Level {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+  };
+  static_assert(sizeof(Ktx2Level) == 24);
+  
+  // 0 for formats outside the subset
+  inline uint32_t getKtx2BlockBytes(Ktx2Format format) {
+    switch(format) {
+      case Ktx2Format::eBC1RgbUnorm:
+      case Ktx2Format::eBC1RgbSrgb: return 8;
+      case Ktx2Format::eBC5Unorm:
+      case Ktx2Format::eBC7Unorm:
+      case Ktx2Format::eBC7Srgb: return 16;
+      case Ktx2Format::eR8G8B8A8Srgb: return 4;
+    }
+    return 0;
+  }
+  
+  inline uint32_t getKtx2BlockDim(Ktx2Format format) {
+    return format == Ktx2Format::eR8G8B8A8Srgb ? 1 : 4;
+  }
+  
+  inline uint64_t getKtx2LevelSize(Ktx2Format format, uint32_t w, uint32_t h) {
+    uint32_t dim = getKtx2BlockDim(format);
+    return static_cast<uint64_t>((w + dim - 1) / dim) * ((h + dim - 1) / dim) * getKtx2BlockBytes(format);
+  }
+  
+  struct Ktx2Image {
+    Ktx2Format format{Ktx2Format::eR8G8B8A8Srgb};
+    uint32_t width{0};
+    uint32_t height{0};
+    std::vector<Ktx2Level> levels; // level 0 is the largest
+  };
+  
+  // validates the header and level index against the file size, level data is left where it is
+  inline bool readKtx2(std::span<const std::byte> file, Ktx2Image& out) {
+    if(file.size() < sizeof(Ktx2Header)) return false;
+    
+    Ktx2Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    
+    if(  std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0
+      || getKtx2BlockBytes(static_cast<Ktx2Format>(header.vkFormat)) == 0
+      || header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1
+      || header.layerCount > 1 || header.faceCount != 1
+      || header.supercompressionScheme != 0
+      || header.levelCount == 0
+      // no more levels than the chain down to 1x1 has, Vulkan rejects such an image
+      || header.levelCount > static_cast<uint32_t>(std::bit_width(std::max(header.pixelWidth, header.pixelHeight)))
+    ) return false;
+    
+    if(file.size() < sizeof(Ktx2Header) + header.levelCount * sizeof(Ktx2Level)) return false;
+    
+    out.format = static_cast<Ktx2Format>(header.vkFormat);
+    out.width = header.pixelWidth;
+    out.height = header.pixelHeight;
+    out.levels.resize(header.levelCount);
+    std::memcpy(out.levels.data(), file.data() + sizeof(Ktx2Header), header.levelCount * sizeof(Ktx2Level));
+    
+    for(uint32_t i = 0; i < header.levelCount; ++i) {
+      const auto& level = out.levels[i];
+      uint64_t expected = getKtx2LevelSize(out.format, std::max(out.width >> i, 1u), std::max(out.height >> i, 1u));
+      if(level.byteLength != expected || level.byteOffset > file.size() || level.byteLength > file.size() - level.byteOffset) {
+        return false;
+      }
+    }
+    
+    return true;
+  }
+
+}; //V
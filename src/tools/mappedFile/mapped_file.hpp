@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <span>
+#include <utility>
+
+#ifdef _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace V {
+  
+  // read-only view of a whole file, pages come in on first touch
+  class MappedFile {
+  public:
+    
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    MappedFile(MappedFile&& other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr))
+      , m_size(std::exchange(other.m_size, 0)) {}
+    
+    MappedFile& operator=(MappedFile&& other) noexcept {
+      if(this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+      }
+      return *this;
+    }
+    
+    bool open(const std::string& path) {
+      close();
+      
+#ifdef _WIN32
+      HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if(file == INVALID_HANDLE_VALUE) return false;
+      
+      LARGE_INTEGER size{};
+      if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+      }
+      
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(file);
+      if(!mapping) return false;
+      
+      void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+      if(!data) return false;
+      
+      m_data = static_cast<const std::byte*>(data);
+      m_size = static_cast<size_t>(size.QuadPart);
+#else
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if(fd < 0) return false;
+      
+      struct stat st{};
+      if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+      }
+      
+      void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if(data == MAP_FAILED) return false;
+      
+      m_data = static_cast<const std::byte*>(data);
+      m_size = static_cast<size_t>(st.st_size);
+#endif
+      
+      return true;
+    }
+    
+    void close() {
+      if(!m_data) return;
+      
+#ifdef _WIN32
+      UnmapViewOfFile(m_data);
+#else
+      munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+      m_data = nullptr;
+      m_size = 0;
+    }
+    
+    const std::byte* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    std::span<const std::byte> bytes() const { return {m_data, m_size}; }
+    
+    explicit operator bool() const { return m_data != nullptr; }
+  
+  private:
+    
+    const std::byte* m_data{nullptr};
+    size_t m_size{0};
+    
+  };
+  
+}; //V
@@ -0,0 +1,256 @@
+#include "bc_encoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace V {
+  
+  namespace {
+    
+    // endpoints of the block's principal axis through its mean, in 0..255
+    template<int N>
+    void findEndpoints(const BlockTexels& texels, float (&lo)[N], float (&hi)[N]) {
+      
+      float mean[N] = {};
+      for(int i = 0; i < 16; ++i) {
+        for(int c = 0; c < N; ++c) mean[c] += texels[i][c];
+      }
+      for(int c = 0; c < N; ++c) mean[c] /= 16.f;
+      
+      float cov[N][N] = {};
+      for(int i = 0; i < 16; ++i) {
+        float d[N];
+        for(int c = 0; c < N; ++c) d[c] = texels[i][c] - mean[c];
+        for(int a = 0; a < N; ++a) {
+          for(int b = 0; b < N; ++b) cov[a][b] += d[a] * d[b];
+        }
+      }
+      
+      // power iteration, seeded with the bounding box diagonal
+      float axis[N];
+      for(int c = 0; c < N; ++c) {
+        uint8_t mn = 255, mx = 0;
+        for(int i = 0; i < 16; ++i) {
+          mn = std::min(mn, texels[i][c]);
+          mx = std::max(mx, texels[i][c]);
+        }
+        axis[c] = static_cast<float>(mx - mn);
+      }
+      for(int iter = 0; iter < 8; ++iter) {
+        float next[N] = {};
+        float len = 0.f;
+        for(int a = 0; a < N; ++a) {
+          for(int b = 0; b < N; ++b) next[a] += cov[a][b] * axis[b];
+          len = std::max(len, std::abs(next[a]));
+        }
+        if(len == 0.f) break;
+        for(int c = 0; c < N; ++c) axis[c] = next[c] / len;
+      }
+      
+      float len = 0.f;
+      for(int c = 0; c < N; ++c) len += axis[c] * axis[c];
+      len = std::sqrt(len);
+      if(len == 0.f) {
+        // flat block
+        for(int c = 0; c < N; ++c) lo[c] = hi[c] = mean[c];
+        return;
+      }
+      for(int c = 0; c < N; ++c) axis[c] /= len;
+      
+      float minP = std::numeric_limits<float>::max();
+      float maxP = std::numeric_limits<float>::lowest();
+      for(int i = 0; i < 16; ++i) {
+        float p = 0.f;
+        for(int c = 0; c < N; ++c) p += (texels[i][c] - mean[c]) * axis[c];
+        minP = std::min(minP, p);
+        maxP = std::max(maxP, p);
+      }
+      
+      for(int c = 0; c < N; ++c) {
+        lo[c] = std::clamp(mean[c] + axis[c] * minP, 0.f, 255.f);
+        hi[c] = std::clamp(mean[c] + axis[c] * maxP, 0.f, 255.f);
+      }
+    }
+    
+    template<int N>
+    uint32_t nearest(const uint8_t* texel, const int (*palette)[4], int count) {
+      uint32_t best = 0;
+      int bestErr = std::numeric_limits<int>::max();
+      for(int i = 0; i < count; ++i) {
+        int err = 0;
+        for(int c = 0; c < N; ++c) {
+          int d = texel[c] - palette[i][c];
+          err += d * d;
+        }
+        if(err < bestErr) {
+          bestErr = err;
+          best = static_cast<uint32_t>(i);
+        }
+      }
+      return best;
+    }
+    
+    uint16_t to565(const float (&c)[3]) {
+      uint16_t r = static_cast<uint16_t>(std::lround(c[0] * 31.f / 255.f));
+      uint16_t g = static_cast<uint16_t>(std::lround(c[1] * 63.f / 255.f));
+      uint16_t b = static_cast<uint16_t>(std::lround(c[2] * 31.f / 255.f));
+      return static_cast<uint16_t>(r << 11 | g << 5 | b);
+    }
+    
+    void from565(uint16_t v, int (&out)[4]) {
+      int r = (v >> 11) & 31;
+      int g = (v >> 5) & 63;
+      int b = v & 31;
+      out[0] = r << 3 | r >> 2;
+      out[1] = g << 2 | g >> 4;
+      out[2] = b << 3 | b >> 2;
+      out[3] = 255;
+    }
+    
+    void encodeBC4(const uint8_t (&values)[16], std::byte* out) {
+      
+      uint8_t r0 = *std::ranges::max_element(values);
+      uint8_t r1 = *std::ranges::min_element(values);
+      
+      out[0] = std::byte{r0};
+      out[1] = std::byte{r1};
+      
+      uint64_t bits = 0;
+      if(r0 > r1) {
+        // eight-value mode: r0, r1, then six steps from r0 towards r1
+        int palette[8][4] = {{r0}, {r1}};
+        for(int i = 2; i < 8; ++i) palette[i][0] = ((8 - i) * r0 + (i - 1) * r1 + 3) / 7;
+        
+        for(int i = 0; i < 16; ++i) {
+          bits |= static_cast<uint64_t>(nearest<1>(&values[i], palette, 8)) << (i * 3);
+        }
+      }
+      
+      for(int i = 0; i < 6; ++i) out[2 + i] = static_cast<std::byte>(bits >> (i * 8));
+    }
+    
+    class BitWriter {
+    public:
+      
+      explicit BitWriter(std::byte* out) : m_out(out) {}
+      
+      void write(uint32_t value, uint32_t bits) {
+        for(uint32_t b = 0; b < bits; ++b, ++m_pos) {
+          if((value >> b) & 1) m_out[m_pos / 8] |= static_cast<std::byte>(1 << (m_pos % 8));
+        }
+      }
+    
+    private:
+      
+      std::byte* m_out;
+      uint32_t m_pos{0};
+    
+    };
+  
+  }; //anon
+  
+  void encodeBC1(const BlockTexels& texels, std::byte* out) {
+    
+    float lo[3], hi[3];
+    findEndpoints<3>(texels, lo, hi);
+    
+    uint16_t c0 = to565(hi);
+    uint16_t c1 = to565(lo);
+    // c0 > c1 selects four-colour mode; equal endpoints decode every index 0 to c0 either way
+    if(c0 < c1) std::swap(c0, c1);
+    
+    int palette[4][4];
+    from565(c0, palette[0]);
+    from565(c1, palette[1]);
+    for(int c = 0; c < 3; ++c) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+    }
+    
+    uint32_t indices = 0;
+    if(c0 != c1) {
+      for(int i = 0; i < 16; ++i) {
+        indices |= nearest<3>(texels[i], palette, 4) << (i * 2);
+      }
+    }
+    
+    std::memcpy(out, &c0, 2);
+    std::memcpy(out + 2, &c1, 2);
+    std::memcpy(out + 4, &indices, 4);
+  }
+  
+  void encodeBC5(const BlockTexels& texels, std::byte* out) {
+    
+    uint8_t red[16], green[16];
+    for(int i = 0; i < 16; ++i) {
+      red[i] = texels[i][0];
+      green[i] = texels[i][1];
+    }
+    
+    encodeBC4(red, out);
+    encodeBC4(green, out + 8);
+  }
+  
+  void encodeBC7(const BlockTexels& texels, std::byte* out) {
+    
+    static constexpr int WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    
+    float ends[2][4];
+    findEndpoints<4>(texels, ends[0], ends[1]);
+    
+    // 7 bits per channel plus one shared low bit per endpoint, whichever p-bit lands closer
+    uint32_t q[2][4];
+    uint32_t p[2];
+    int e[2][4];
+    for(int j = 0; j < 2; ++j) {
+      float bestErr = std::numeric_limits<float>::max();
+      for(uint32_t pb = 0; pb < 2; ++pb) {
+        float err = 0.f;
+        uint32_t cand[4];
+        for(int c = 0; c < 4; ++c) {
+          cand[c] = static_cast<uint32_t>(std::clamp(std::lround((ends[j][c] - pb) / 2.f), 0l, 127l));
+          float d = static_cast<float>(cand[c] << 1 | pb) - ends[j][c];
+          err += d * d;
+        }
+        if(err < bestErr) {
+          bestErr = err;
+          p[j] = pb;
+          std::copy(cand, cand + 4, q[j]);
+        }
+      }
+      for(int c = 0; c < 4; ++c) e[j][c] = static_cast<int>(q[j][c] << 1 | p[j]);
+    }
+    
+    int palette[16][4];
+    for(int i = 0; i < 16; ++i) {
+      for(int c = 0; c < 4; ++c) {
+        palette[i][c] = (e[0][c] * (64 - WEIGHTS[i]) + e[1][c] * WEIGHTS[i] + 32) >> 6;
+      }
+    }
+    
+    uint32_t indices[16];
+    for(int i = 0; i < 16; ++i) indices[i] = nearest<4>(texels[i], palette, 16);
+    
+    // the anchor index is stored without its top bit, so it has to be below 8
+    if(indices[0] & 8) {
+      std::swap(q[0], q[1]);
+      std::swap(p[0], p[1]);
+      for(auto& idx : indices) idx = 15 - idx;
+    }
+    
+    std::memset(out, 0, 16);
+    BitWriter bits(out);
+    bits.write(1 << 6, 7);
+    for(int c = 0; c < 4; ++c) {
+      bits.write(q[0][c], 7);
+      bits.write(q[1][c], 7);
+    }
+    bits.write(p[0], 1);
+    bits.write(p[1], 1);
+    bits.write(indices[0], 3);
+    for(int i = 1; i < 16; ++i) bits.write(indices[i], 4);
+  }
+
+}; //V
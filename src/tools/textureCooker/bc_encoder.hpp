@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace V {
+  
+  // one 4x4 block, row-major RGBA8 texels
+  using BlockTexels = uint8_t[16][4];
+  
+  // opaque BC1 (four-colour mode), 8 bytes
+  void encodeBC1(const BlockTexels& texels, std::byte* out);
+  // red and green as two BC4 channels, 16 bytes
+  void encodeBC5(const BlockTexels& texels, std::byte* out);
+  // single-subset mode 6 with alpha, 16 bytes
+  void encodeBC7(const BlockTexels& texels, std::byte* out);
+
+}; //V
@@ -0,0 +1,314 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "bc_encoder.hpp"
+#include "../ktx2/ktx2.hpp"
+#include "../logger/logger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <optional>
+#include <algorithm>
+#include <cstring>
+
+// offline: TextureCooker [--role albedo|normal|mask] <image>... writes <image stem>.ktx2 next to each input,
+// which VulkanTexture picks up instead of the source
+namespace V {
+  
+  enum class TextureRole {
+    eAlbedo, // BC7 sRGB, keeps alpha
+    eNormal, // BC5, tangent-space XY, Z is rebuilt when sampled
+    eMask    // BC1 linear, opaque single / three channel data
+  };
+  
+  namespace {
+    
+    bool parseRole(std::string_view name, TextureRole& role) {
+      if(name == "albedo") role = TextureRole::eAlbedo;
+      else if(name == "normal") role = TextureRole::eNormal;
+      else if(name == "mask") role = TextureRole::eMask;
+      else return false;
+      return true;
+    }
+    
+    // the usual suffixes when no role is given
+    TextureRole guessRole(const std::filesystem::path& path) {
+      std::string stem = path.stem().string();
+      std::ranges::transform(stem, stem.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      
+      if(stem.ends_with("_n") || stem.ends_with("_nrm") || stem.ends_with("normal")) return TextureRole::eNormal;
+      if(stem.ends_with("_r") || stem.ends_with("_ao") || stem.ends_with("_orm") || stem.ends_with("roughness") || stem.ends_with("metallic")) {
+        return TextureRole::eMask;
+      }
+      return TextureRole::eAlbedo;
+    }
+    
+    Ktx2Format getFormat(TextureRole role) {
+      switch(role) {
+        case TextureRole::eAlbedo: return Ktx2Format::eBC7Srgb;
+        case TextureRole::eNormal: return Ktx2Format::eBC5Unorm;
+        case TextureRole::eMask: return Ktx2Format::eBC1RgbUnorm;
+      }
+      return Ktx2Format::eBC7Srgb;
+    }
+    
+    // RGBA floats in the space the role filters in: linear light for albedo, unit vectors for normals
+    struct Level {
+      uint32_t w{0};
+      uint32_t h{0};
+      std::vector<float> texels;
+    };
+    
+    float srgbToLinear(float c) {
+      return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    
+    float linearToSrgb(float c) {
+      return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+    }
+    
+    Level toLevel(const stbi_uc* pixels, uint32_t w, uint32_t h, TextureRole role) {
+      Level level{w, h, std::vector<float>(static_cast<size_t>(w) * h * 4)};
+      
+      for(size_t i = 0; i < level.texels.size(); ++i) {
+        float v = pixels[i] / 255.f;
+        bool color = i % 4 != 3;
+        if(role == TextureRole::eAlbedo && color) v = srgbToLinear(v);
+        if(role == TextureRole::eNormal && color) v = v * 2.f - 1.f;
+        level.texels[i] = v;
+      }
+      
+      return level;
+    }
+    
+    std::vector<uint8_t> toBytes(const Level& level, TextureRole role) {
+      std::vector<uint8_t> out(level.texels.size());
+      
+      for(size_t i = 0; i < out.size(); ++i) {
+        float v = level.texels[i];
+        bool color = i % 4 != 3;
+        if(role == TextureRole::eAlbedo && color) v = linearToSrgb(v);
+        if(role == TextureRole::eNormal && color) v = v * .5f + .5f;
+        out[i] = static_cast<uint8_t>(std::lround(std::clamp(v, 0.f, 1.f) * 255.f));
+      }
+      
+      return out;
+    }
+    
+    Level downsample(const Level& src, TextureRole role) {
+      Level dst{std::max(src.w / 2, 1u), std::max(src.h / 2, 1u), {}};
+      dst.texels.resize(static_cast<size_t>(dst.w) * dst.h * 4);
+      
+      for(uint32_t y = 0; y < dst.h; ++y) {
+        for(uint32_t x = 0; x < dst.w; ++x) {
+          float* out = &dst.texels[(static_cast<size_t>(y) * dst.w + x) * 4];
+          
+          // odd edges clamp, the last row / column is averaged with itself
+          for(uint32_t sy : {std::min(y * 2, src.h - 1), std::min(y * 2 + 1, src.h - 1)}) {
+            for(uint32_t sx : {std::min(x * 2, src.w - 1), std::min(x * 2 + 1, src.w - 1)}) {
+              const float* in = &src.texels[(static_cast<size_t>(sy) * src.w + sx) * 4];
+              for(int c = 0; c < 4; ++c) out[c] += in[c] * .25f;
+            }
+          }
+          
+          if(role == TextureRole::eNormal) {
+            float len = std::sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+            if(len > 0.f) {
+              for(int c = 0; c < 3; ++c) out[c] /= len;
+            }
+          }
+        }
+      }
+      
+      return dst;
+    }
+    
+    std::vector<std::byte> encodeLevel(const Level& level, TextureRole role, Ktx2Format format) {
+      std::vector<uint8_t> bytes = toBytes(level, role);
+      uint32_t blocksX = (level.w + 3) / 4;
+      uint32_t blocksY = (level.h + 3) / 4;
+      uint32_t blockBytes = getKtx2BlockBytes(format);
+      
+      std::vector<std::byte> out(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+      
+      for(uint32_t by = 0; by < blocksY; ++by) {
+        for(uint32_t bx = 0; bx < blocksX; ++bx) {
+          // levels smaller than a block repeat their edge texels
+          BlockTexels block;
+          for(uint32_t i = 0; i < 16; ++i) {
+            uint32_t x = std::min(bx * 4 + i % 4, level.w - 1);
+            uint32_t y = std::min(by * 4 + i / 4, level.h - 1);
+            std::memcpy(block[i], &bytes[(static_cast<size_t>(y) * level.w + x) * 4], 4);
+          }
+          
+          std::byte* dst = out.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+          switch(format) {
+            case Ktx2Format::eBC1RgbUnorm:
+            case Ktx2Format::eBC1RgbSrgb: encodeBC1(block, dst); break;
+            case Ktx2Format::eBC5Unorm: encodeBC5(block, dst); break;
+            default: encodeBC7(block, dst); break;
+          }
+        }
+      }
+      
+      return out;
+    }
+    
+    // basic data format descriptor, required by the container even though VkFormat already says it all
+    std::vector<uint32_t> buildDfd(Ktx2Format format) {
+      
+      uint32_t model = 0;
+      uint32_t bits = getKtx2BlockBytes(format) * 8;
+      std::vector<std::pair<uint32_t, uint32_t>> samples; // channel, bit offset
+      switch(format) {
+        case Ktx2Format::eBC1RgbUnorm:
+        case Ktx2Format::eBC1RgbSrgb: model = 128; samples = {{0, 0}}; break;
+        case Ktx2Format::eBC5Unorm: model = 132; bits = 64; samples = {{0, 0}, {1, 64}}; break;
+        default: model = 134; samples = {{0, 0}}; break;
+      }
+      bool srgb = format == Ktx2Format::eBC1RgbSrgb || format == Ktx2Format::eBC7Srgb;
+      
+      uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+      std::vector<uint32_t> dfd = {
+        4 + blockSize,                        // total size
+        0,                                    // Khronos vendor, basic descriptor
+        2 | blockSize << 16,                  // version 2
+        model | 1 << 8 | (srgb ? 2u : 1u) << 16, // BT.709 primaries, sRGB / linear transfer, straight alpha
+        3 | 3 << 8,                           // 4x4x1x1 texel block
+        getKtx2BlockBytes(format),
+        0
+      };
+      for(auto [channel, offset] : samples) {
+        dfd.insert(dfd.end(), {offset | (bits - 1) << 16 | channel << 24, 0, 0, 0xFFFFFFFFu});
+      }
+      
+      return dfd;
+    }
+    
+    bool writeKtx2(const std::string& path, Ktx2Format format, uint32_t w, uint32_t h, const std::vector<std::vector<std::byte>>& levels) {
+      
+      std::vector<uint32_t> dfd = buildDfd(format);
+      uint32_t levelCount = static_cast<uint32_t>(levels.size());
+      uint32_t align = getKtx2BlockBytes(format);
+      
+      Ktx2Header header{};
+      std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+      header.vkFormat = static_cast<uint32_t>(format);
+      header.typeSize = 1;
+      header.pixelWidth = w;
+      header.pixelHeight = h;
+      header.faceCount = 1;
+      header.levelCount = levelCount;
+      header.dfdByteOffset = static_cast<uint32_t>(sizeof(Ktx2Header) + levelCount * sizeof(Ktx2Level));
+      header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+      
+      // smallest level first, as the container wants it
+      std::vector<Ktx2Level> index(levelCount);
+      uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+      for(uint32_t i = levelCount; i-- > 0;) {
+        offset = (offset + align - 1) / align * align;
+        index[i] = {offset, levels[i].size(), levels[i].size()};
+        offset += levels[i].size();
+      }
+      
+      std::vector<std::byte> data(offset);
+      std::memcpy(data.data(), &header, sizeof(header));
+      std::memcpy(data.data() + sizeof(header), index.data(), index.size() * sizeof(Ktx2Level));
+      std::memcpy(data.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+      for(uint32_t i = 0; i < levelCount; ++i) {
+        std::memcpy(data.data() + index[i].byteOffset, levels[i].data(), levels[i].size());
+      }
+      
+      // written aside and renamed, the engine never sees half a file
+      std::string tmpPath = path + ".tmp";
+      {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if(!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+          Logger::error("Failed to write {}", tmpPath);
+          return false;
+        }
+      }
+      
+      std::error_code ec;
+      std::filesystem::rename(tmpPath, path, ec);
+      if(ec) {
+        Logger::error("Failed to write {}: {}", path, ec.message());
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+      }
+      
+      return true;
+    }
+    
+    bool cook(const std::filesystem::path& input, TextureRole role) {
+      
+      int w, h, channels;
+      stbi_uc* pixels = stbi_load(input.string().c_str(), &w, &h, &channels, STBI_rgb_alpha);
+      if(!pixels) {
+        Logger::error("Failed to load {}: {}", input.string(), stbi_failure_reason());
+        return false;
+      }
+      
+      Ktx2Format format = getFormat(role);
+      std::vector<std::vector<std::byte>> levels;
+      
+      Level level = toLevel(pixels, static_cast<uint32_t>(w), static_cast<uint32_t>(h), role);
+      stbi_image_free(pixels);
+      
+      // each level is filtered from the previous one, at full float precision
+      while(true) {
+        levels.push_back(encodeLevel(level, role, format));
+        if(level.w == 1 && level.h == 1) break;
+        level = downsample(level, role);
+      }
+      
+      std::filesystem::path output = input;
+      output.replace_extension(".ktx2");
+      if(!writeKtx2(output.string(), format, static_cast<uint32_t>(w), static_cast<uint32_t>(h), levels)) return false;
+      
+      size_t bytes = 0;
+      for(const auto& l : levels) bytes += l.size();
+      Logger::info("Cooked {} -> {} ({}x{}, {} mips, {:.2f} MB)",
+        input.string(), output.string(), w, h, levels.size(), static_cast<float>(bytes) / (1024.f * 1024.f)
+      );
+      return true;
+    }
+  
+  }; //anon
+
+}; //V
+
+int main(int argc, char** argv) {
+  
+  std::optional<V::TextureRole> role;
+  std::vector<std::filesystem::path> inputs;
+  
+  for(int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if(arg == "--role" && i + 1 < argc) {
+      V::TextureRole r;
+      if(!V::parseRole(argv[++i], r)) {
+        V::Logger::error("Unknown role {}, expected albedo, normal or mask", argv[i]);
+        return 1;
+      }
+      role = r;
+    } else {
+      inputs.emplace_back(arg);
+    }
+  }
+  
+  if(inputs.empty()) {
+    V::Logger::info("Usage: TextureCooker [--role albedo|normal|mask] <image>...");
+    return 1;
+  }
+  
+  int failed = 0;
+  for(const auto& input : inputs) {
+    if(!V::cook(input, role.value_or(V::guessRole(input)))) ++failed;
+  }
+  
+  return failed == 0 ? 0 : 1;
+}